@@ -1,10 +1,12 @@
-#ifndef FOWLER_NOLL_VO_1A_32_BIT_HASH
-#define FOWLER_NOLL_VO_1A_32_BIT_HASH
+#ifndef FOWLER_NOLL_VO_1A_HASH
+#define FOWLER_NOLL_VO_1A_HASH
 
 #include "compiler_attributes_macros.h"
 
 #include <stddef.h>  // size_t
-#include <stdint.h>  // uint32_t
+#include <stdint.h>  // uint32_t, uint64_t
+
+#ifndef FNV64A_HASH_FUNC
 
 /*! @brief FNV-0 and FNV-1 32 bit magic prime. */
 #define FNV_32_PRIME ((uint32_t)0x01000193U)
@@ -50,4 +52,47 @@ static void fnv32a_hash(
 #undef FNV_32_PRIME
 #undef FNV1_32_INIT
 
-#endif /* FOWLER_NOLL_VO_1A_32_BIT_HASH */
+#else
+
+/*! @brief FNV-1 and FNV-1a 64 bit magic prime. */
+#define FNV_64_PRIME ((uint64_t)0x100000001b3ULL)
+/*! @brief FNV-1 and FNV-1a 64 bit non-zero initial basis. */
+#define FNV1_64_INIT ((uint64_t)0xcbf29ce484222325ULL)
+
+static void fnv64a_hash(
+	const unsigned char *const restrict buffer, const size_t len,
+	void *const restrict out
+) _nonnull;
+
+/*!
+ * @brief perform a 64 bit Fowler/Noll/Vo FNV-1a hash on a buffer.
+ *
+ * @param buffer start of buffer to hash.
+ * @param len length of buffer in octets.
+ * @param out pointer to an initialised 8 byte wide address to store the hash.
+ *
+ * `out` should be initialised to `FNV1_64_INIT` or the previous hash.
+ */
+static void fnv64a_hash(
+	const unsigned char *const buffer, const size_t len,
+	void *const restrict out
+)
+{
+	const unsigned char *const buf_end = buffer + len;
+	uint64_t *const restrict dest = out;
+
+	for (const unsigned char *buf_p = buffer; buf_p < buf_end; buf_p++)
+	{
+		/* xor the bottom with the current octet */
+		*dest ^= *buf_p;
+		/* multiply by the 64 bit FNV magic prime mod 2^64 */
+		*dest *= FNV_64_PRIME;
+	}
+}
+
+#undef FNV_64_PRIME
+#undef FNV1_64_INIT
+
+#endif /* FNV64A_HASH_FUNC */
+
+#endif /* FOWLER_NOLL_VO_1A_HASH */
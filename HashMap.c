@@ -4,8 +4,31 @@
 
 #define HASHMAP_UNIQUE_SUFFIX int
 #define HASHMAP_DATATYPE int
+#define HASHMAP_INLINE_KEY_SIZE 16
+#define HASHMAP_CONCURRENT
+#define HASHMAP_SHARDED
+#define HASHMAP_PARALLEL_GROW
+#define HASHMAP_HANDLE
+#define HASHMAP_AUTO_SHRINK
 #include "HashMap_methods.c"
 
 #define HASHMAP_UNIQUE_SUFFIX str
 #define HASHMAP_DATATYPE char *
 #include "HashMap_methods.c"
+
+#define HASHMAP_UNIQUE_SUFFIX id
+#define HASHMAP_DATATYPE int
+#define HASHMAP_KEYTYPE uint64_t
+#define HASHMAP_RCU
+#define HASHMAP_AUTO_SHRINK
+#include "HashMap_methods.c"
+
+#define HASHMAP_UNIQUE_SUFFIX sym
+#define HASHMAP_DATATYPE int
+#define HASHMAP_INTERN
+#include "HashMap_methods.c"
+
+#define HASHMAP_UNIQUE_SUFFIX huge
+#define HASHMAP_DATATYPE int
+#define HASHMAP_HUGE_PAGES
+#include "HashMap_methods.c"
@@ -6,8 +6,10 @@
 	#error "Missing definition for `HASHMAP_DATATYPE`."
 #endif /* HASHMAP_DATATYPE */
 
+#include <limits.h> /* CHAR_BIT */
 #include <stddef.h> /* offsetof */
 #include <stdio.h>  /* sprintf */
+#include <stdlib.h> /* aligned_alloc, free */
 #include <string.h> /* memcmp */
 
 #define COMMON_CALLBACKS_UNIQUE_SUFFIX HASHMAP_UNIQUE_SUFFIX
@@ -16,20 +18,74 @@
 
 #include "xalloc/xalloc.h"
 
-#if !defined FNV32A_HASH_FUNC
-
-	#ifndef MURMURHASH3_x86_32_HASH_FUNC
+#ifdef HASHMAP_PARALLEL_GROW
+	#include <threads.h> /* thrd_create, thrd_join */
+#endif /* HASHMAP_PARALLEL_GROW */
+
+#if defined HASHMAP_KEY_HASH && !defined HASHMAP_KEYTYPE
+	#error "`HASHMAP_KEY_HASH` needs a `HASHMAP_KEYTYPE`."
+#endif /* defined HASHMAP_KEY_HASH && !defined HASHMAP_KEYTYPE */
+
+#if defined HASHMAP_KEY_EQ && !defined HASHMAP_KEYTYPE
+	#error "`HASHMAP_KEY_EQ` needs a `HASHMAP_KEYTYPE`."
+#endif /* defined HASHMAP_KEY_EQ && !defined HASHMAP_KEYTYPE */
+
+// #define WYHASH_HASH_FUNC
+// #define RUNTIME_HASH_FUNC
+
+#if defined HASHMAP_KEYTYPE
+	/* `HASHMAP_KEY_HASH` or the seed mixer hash the keys. */
+#elif defined RUNTIME_HASH_FUNC
+	/* The fastest hash the CPU supports, chosen at startup. */
+	#include "hash_dispatch.c"
+#elif defined WYHASH_HASH_FUNC
+	#include "wyhash.c"
+#elif !defined FNV32A_HASH_FUNC
+
+	#ifdef HASHMAP_64BIT_HASH
+		#ifndef MURMURHASH3_x64_128_HASH_FUNC
+			#define MURMURHASH3_x64_128_HASH_FUNC
+		#endif /* MURMURHASH3_x64_128_HASH_FUNC */
+	#elif !defined MURMURHASH3_x86_32_HASH_FUNC
 		#define MURMURHASH3_x86_32_HASH_FUNC
-	#endif /* MURMURHASH3_x86_32_HASH_FUNC */
+	#endif /* HASHMAP_64BIT_HASH */
 
 	#include "MurmurHash3.c"
 
 #elif defined FNV32A_HASH_FUNC
+
+	/* 64 bit hashes use the 64 bit variant of FNV-1a. */
+	#if defined HASHMAP_64BIT_HASH && !defined FNV64A_HASH_FUNC
+		#define FNV64A_HASH_FUNC
+	#endif /* defined HASHMAP_64BIT_HASH && !defined FNV64A_HASH_FUNC */
+
 	#include "FNV-1a.c"
-#endif /* !defined FNV32A_HASH_FUNC */
+#endif /* defined RUNTIME_HASH_FUNC */
+
+#include "random_seed.c"
 
 /* Helper macro functions. */
 
+#ifdef HASHMAP_KEYTYPE
+	#define KEY_TY HASHMAP_KEYTYPE
+	#define KEY_ISVALID(key) true
+	#ifdef HASHMAP_KEY_EQ
+		#define KEY_EQ(key0, key1) HASHMAP_KEY_EQ(key0, key1)
+	#else
+		#define KEY_EQ(key0, key1) ((key0) == (key1))
+	#endif /* HASHMAP_KEY_EQ */
+#else
+	#define KEY_TY u8mem
+	#define KEY_ISVALID(key) ((key).buf && (key).len > 0)
+	#ifdef HASHMAP_INTERN
+		/* Keys from handles are the very bytes in the Buckets. */
+		#define KEY_EQ(key0, key1)                                            \
+			((key0).buf == (key1).buf || u8mem_compare(key0, key1) == 0)
+	#else
+		#define KEY_EQ(key0, key1) (u8mem_compare(key0, key1) == 0)
+	#endif /* HASHMAP_INTERN */
+#endif /* HASHMAP_KEYTYPE */
+
 // #define POWER2_ROUNDUP_FUNC
 
 #ifdef POWER2_ROUNDUP_FUNC
@@ -40,6 +96,55 @@
 	#define FOLD(hash, capacity) (hash % capacity)
 #endif /* POWER2_ROUNDUP_FUNC */
 
+#ifdef SWISS_TABLE_PROBING
+	#include "ctrl_group.c"
+
+	/* The control bytes are stored right after the last Bucket. */
+	#define CTRL_BYTES(hm) ((unsigned char *)&(hm)->arr[(hm)->capacity])
+	#define CTRL_BYTES_SIZE(capacity) ((capacity) + CTRL_GROUP_WIDTH - 1)
+	/* The top 7 bits of the hash, FOLD uses the bottom bits. */
+	#define HASH_TAG(hash)                                                    \
+		((unsigned char)((hash) >> (sizeof(hash_ty) * CHAR_BIT - 7)))
+#endif /* SWISS_TABLE_PROBING */
+
+#ifdef CELLAR_COALESCED_HASHING
+	#define SLOT_COUNT(hm) ((hm)->capacity + (hm)->cellar.capacity)
+#else
+	#define SLOT_COUNT(hm) ((hm)->capacity)
+#endif /* CELLAR_COALESCED_HASHING */
+
+#ifdef HOT_COLD_SPLIT
+	/* The Links are stored right after the last Bucket. */
+	#define LINKS(hm) ((LINK_STRUCT_TAG *)&(hm)->arr[SLOT_COUNT(hm)])
+	#define LINK(hm, bkt) (LINKS(hm)[(bkt) - (hm)->arr])
+	#define NEXT_POS(hm, bkt) (LINK(hm, bkt).next_pos)
+	#define HASH_OF(hm, bkt) (LINK(hm, bkt).hash)
+#else
+	#define NEXT_POS(hm, bkt) ((bkt)->next_pos)
+	#define HASH_OF(hm, bkt) ((bkt)->hash)
+#endif /* HOT_COLD_SPLIT */
+
+#if !defined SWISS_TABLE_PROBING && !defined ROBIN_HOOD_HASHING &&           \
+	!defined EMPTY_BUCKET_STACK
+	#define OCCUPANCY_BITMAP
+	#include "occupancy_bitmap.c"
+
+	/* The bitmap is stored after the Buckets and the Links. */
+	#ifdef HOT_COLD_SPLIT
+		#define OCCUPANCY(hm)                                                 \
+			bitmap_align((unsigned char *)(LINKS(hm) + SLOT_COUNT(hm)))
+	#else
+		#define OCCUPANCY(hm)                                                 \
+			bitmap_align((unsigned char *)&(hm)->arr[SLOT_COUNT(hm)])
+	#endif /* HOT_COLD_SPLIT */
+#endif /* !defined SWISS_TABLE_PROBING && !defined ROBIN_HOOD_HASHING */
+
+#ifdef __GNUC__
+	#define PREFETCH(address) __builtin_prefetch(address)
+#else
+	#define PREFETCH(address) ((void)(address))
+#endif /* __GNUC__ */
+
 #define POS_TO_PTR(array, position)                                           \
 	((position) > 0 ? &(array)[(position) - 1] : NULL)
 #define PTR_TO_POS(array, pointer) ((pointer) ? (pointer) - (array) + 1 : 0)
@@ -52,6 +157,16 @@
 #define HASHMAP_STRUCT_TAG HM_CONCAT(HashMap_, HASHMAP_UNIQUE_SUFFIX)
 #define BUCKET_STRUCT_TAG HM_CONCAT(Bucket_, HASHMAP_UNIQUE_SUFFIX)
 #define CELLAR_STRUCT_TAG HM_CONCAT(Cellar_, HASHMAP_UNIQUE_SUFFIX)
+#define LINK_STRUCT_TAG HM_CONCAT(Link_, HASHMAP_UNIQUE_SUFFIX)
+#define INTERNED_STRUCT_TAG HM_CONCAT(Interned_, HASHMAP_UNIQUE_SUFFIX)
+#define STRIPE_STRUCT_TAG HM_CONCAT(Stripe_, HASHMAP_UNIQUE_SUFFIX)
+#define CONCURRENT_STRUCT_TAG                                                 \
+	HM_CONCAT(ConcurrentHashMap_, HASHMAP_UNIQUE_SUFFIX)
+#define SHARDED_STRUCT_TAG HM_CONCAT(ShardedHashMap_, HASHMAP_UNIQUE_SUFFIX)
+#define GROW_TASK_STRUCT_TAG HM_CONCAT(GrowTask_, HASHMAP_UNIQUE_SUFFIX)
+#define READER_STRUCT_TAG HM_CONCAT(Reader_, HASHMAP_UNIQUE_SUFFIX)
+#define RCU_STRUCT_TAG HM_CONCAT(RcuHashMap_, HASHMAP_UNIQUE_SUFFIX)
+#define HANDLE_STRUCT_TAG HM_CONCAT(HashMapHandle_, HASHMAP_UNIQUE_SUFFIX)
 
 #define HASHMAP_METHODNAME(name)                                              \
 	HM_CONCAT(HM_CONCAT(hm_, HASHMAP_UNIQUE_SUFFIX), HM_CONCAT(_, name))
@@ -61,26 +176,94 @@
 /* Forward declarations. */
 
 static bool BUCKET_METHODNAME(islive)(const BUCKET_STRUCT_TAG bkt);
+static KEY_TY BUCKET_METHODNAME(getkey)(
+	const BUCKET_STRUCT_TAG *const restrict bkt
+) _nonnull;
+static bool BUCKET_METHODNAME(setkey)(
+	BUCKET_STRUCT_TAG *const restrict bkt, const KEY_TY key,
+	const allocator *const a
+) _nonnull_pos(1);
+static void BUCKET_METHODNAME(freekey)(
+	BUCKET_STRUCT_TAG *const restrict bkt, const allocator *const a
+) _nonnull_pos(1);
+static void BUCKET_METHODNAME(count_key)(
+	const BUCKET_STRUCT_TAG *const restrict bkt, len_ty *const restrict bytes,
+	len_ty *const restrict blocks, const len_ty sign
+) _nonnull;
+#if !defined SWISS_TABLE_PROBING && !defined ROBIN_HOOD_HASHING
 static void BUCKET_METHODNAME(unlink)(
 	HASHMAP_STRUCT_TAG *const restrict hm,
 	BUCKET_STRUCT_TAG *const restrict bkt
 ) _nonnull;
+#endif /* !defined SWISS_TABLE_PROBING && !defined ROBIN_HOOD_HASHING */
 static char *BUCKET_METHODNAME(tostr)(
 	const BUCKET_STRUCT_TAG bucket,
 	HM_CONCAT(stringify_data_, HASHMAP_UNIQUE_SUFFIX) * data_tostr
 ) _nonnull;
 
+static HASHMAP_STRUCT_TAG *HASHMAP_METHODNAME(copy_table)(
+	const HASHMAP_STRUCT_TAG *const hm,
+	HM_CONCAT(duplicate_, HASHMAP_UNIQUE_SUFFIX) data_dup,
+	HM_CONCAT(free_mem_, HASHMAP_UNIQUE_SUFFIX) data_free, const bool share_keys
+) _nonnull_pos(1);
+#if defined HASHMAP_RCU || defined INCREMENTAL_RESIZE
+static void *
+	HASHMAP_METHODNAME(release)(HASHMAP_STRUCT_TAG *const hm) _nonnull;
+#endif /* defined HASHMAP_RCU || defined INCREMENTAL_RESIZE */
+static len_ty HASHMAP_METHODNAME(next_capacity)(
+	const HASHMAP_STRUCT_TAG *const hm
+) _nonnull;
 static HASHMAP_STRUCT_TAG *
 	HASHMAP_METHODNAME(double_capacity)(HASHMAP_STRUCT_TAG *const hm) _nonnull;
+static HASHMAP_STRUCT_TAG *HASHMAP_METHODNAME(rehash)(
+	HASHMAP_STRUCT_TAG *const hm, const len_ty capacity
+) _nonnull;
+static HASHMAP_STRUCT_TAG *HASHMAP_METHODNAME(resize)(
+	HASHMAP_STRUCT_TAG *const hm, const len_ty capacity
+) _nonnull;
+static HASHMAP_STRUCT_TAG *
+	HASHMAP_METHODNAME(reseed)(HASHMAP_STRUCT_TAG *const hm) _nonnull;
+static void HASHMAP_METHODNAME(reseed_long_chain)(
+	HASHMAP_STRUCT_TAG *restrict *const hm
+) _nonnull;
+static BUCKET_STRUCT_TAG *HASHMAP_METHODNAME(put)(
+	HASHMAP_STRUCT_TAG *restrict *const hm, const hash_ty hash,
+	const KEY_TY key, HASHMAP_DATATYPE data, const bool overwrite
+) _nonnull;
+static len_ty HASHMAP_METHODNAME(count)(const HASHMAP_STRUCT_TAG *const hm);
+static hash_ty
+	HASHMAP_METHODNAME(hash_key)(const uint64_t seed, const KEY_TY key);
+#ifdef INCREMENTAL_RESIZE
+static void HASHMAP_METHODNAME(migrate)(
+	HASHMAP_STRUCT_TAG *const hm, len_ty slots
+) _nonnull;
+#endif /* INCREMENTAL_RESIZE */
+#if defined SWISS_TABLE_PROBING
+static void HASHMAP_METHODNAME(set_ctrl)(
+	HASHMAP_STRUCT_TAG *const hm, const len_ty i, const unsigned char tag
+) _nonnull;
+#elif defined ROBIN_HOOD_HASHING
+static len_ty HASHMAP_METHODNAME(probe_distance)(
+	const HASHMAP_STRUCT_TAG *const hm, const len_ty i
+) _nonnull;
+#else
 static BUCKET_STRUCT_TAG *
 	HASHMAP_METHODNAME(get_empty)(HASHMAP_STRUCT_TAG *const hm);
+#endif /* defined SWISS_TABLE_PROBING */
 static bool HASHMAP_METHODNAME(isvalid)(const HASHMAP_STRUCT_TAG *const hm);
+static len_ty HASHMAP_METHODNAME(find_slot)(
+	HASHMAP_STRUCT_TAG *const hm, const hash_ty hash
+) _nonnull;
 static BUCKET_STRUCT_TAG *HASHMAP_METHODNAME(place)(
-	HASHMAP_STRUCT_TAG *const hm, BUCKET_STRUCT_TAG bucket
+	HASHMAP_STRUCT_TAG *const hm, BUCKET_STRUCT_TAG bucket, const len_ty slot
 ) _nonnull;
 static BUCKET_STRUCT_TAG *HASHMAP_METHODNAME(search_key)(
-	HASHMAP_STRUCT_TAG *const hm, const hash_ty hash, const u8mem key
+	HASHMAP_STRUCT_TAG *const hm, const hash_ty hash, const KEY_TY key,
+	len_ty *const slot
 );
+static void HASHMAP_METHODNAME(evict)(
+	HASHMAP_STRUCT_TAG *const hm, BUCKET_STRUCT_TAG *hole
+) _nonnull;
 
 /*!
  * @brief check if a `Bucket` is in use.
@@ -90,7 +273,288 @@ static BUCKET_STRUCT_TAG *HASHMAP_METHODNAME(search_key)(
  */
 static bool BUCKET_METHODNAME(islive)(const BUCKET_STRUCT_TAG bkt)
 {
+#if defined HASHMAP_KEYTYPE
+	return (bkt.live);
+#elif defined HASHMAP_INLINE_KEY_SIZE
+	return (bkt.key_len > 0);
+#else
 	return (bkt.key != NULL);
+#endif /* defined HASHMAP_KEYTYPE */
+}
+
+/*!
+ * @brief get the key of a live `Bucket`.
+ *
+ * @param bkt pointer to the Bucket.
+ * @returns the key, inline keys point into the Bucket.
+ */
+static KEY_TY
+BUCKET_METHODNAME(getkey)(const BUCKET_STRUCT_TAG *const restrict bkt)
+{
+#if defined HASHMAP_KEYTYPE
+	return (bkt->key);
+#elif defined HASHMAP_INLINE_KEY_SIZE
+	if (bkt->key_len <= HASHMAP_INLINE_KEY_SIZE)
+		return ((u8mem){
+			.len = bkt->key_len, .buf = (unsigned char *)bkt->key.buf
+		});
+
+	return (*bkt->key.mem);
+#elif defined HASHMAP_INTERN
+	return (bkt->key->key);
+#else
+	return (*bkt->key);
+#endif /* defined HASHMAP_KEYTYPE */
+}
+
+#if !defined HASHMAP_KEYTYPE && !defined HASHMAP_INTERN
+/*!
+ * @brief copy a key into a `u8mem` allocated from an `allocator`.
+ *
+ * @param key the key to copy.
+ * @param a the allocator, NULL for `xmalloc`.
+ * @returns pointer to the copy, NULL on failure.
+ */
+static u8mem *BUCKET_METHODNAME(newkey)(
+	const u8mem key, const allocator *const a
+)
+{
+	/* overflow error. */
+	if (key.len < 1 || (size_t)key.len > PTRDIFF_MAX - sizeof(u8mem))
+		return (NULL);
+
+	u8mem *const restrict m = allocator_alloc(a, sizeof(*m) + key.len);
+
+	if (!m)
+		return (NULL);
+
+	*m = (u8mem){.len = key.len, .buf = (unsigned char *)(m + 1)};
+	memcpy(m->buf, key.buf, key.len);
+	return (m);
+}
+#endif /* !defined HASHMAP_KEYTYPE && !defined HASHMAP_INTERN */
+
+/*!
+ * @brief size of the memory allocated for the key of a `Bucket`.
+ *
+ * @param bkt pointer to the Bucket.
+ * @returns the size in bytes, 0 if the key is stored in the Bucket.
+ */
+static len_ty BUCKET_METHODNAME(keysize)(
+	const BUCKET_STRUCT_TAG *const restrict bkt
+)
+{
+#if defined HASHMAP_KEYTYPE
+	(void)bkt;
+	return (0);
+#elif defined HASHMAP_INLINE_KEY_SIZE
+	if (bkt->key_len <= HASHMAP_INLINE_KEY_SIZE)
+		return (0);
+
+	return (sizeof(*bkt->key.mem) + bkt->key_len);
+#elif defined HASHMAP_INTERN
+	return (bkt->key ? sizeof(*bkt->key) + bkt->key->key.len : 0);
+#else
+	return (bkt->key ? sizeof(*bkt->key) + bkt->key->len : 0);
+#endif /* defined HASHMAP_KEYTYPE */
+}
+
+/*!
+ * @brief store a copy of a key in a `Bucket`.
+ *
+ * @param bkt pointer to the Bucket, interned keys cache its hash.
+ * @param key the key to copy.
+ * @param a allocator of the copy, NULL for `xmalloc`.
+ * @returns true on success, false on failure.
+ */
+static bool BUCKET_METHODNAME(setkey)(
+	BUCKET_STRUCT_TAG *const restrict bkt, const KEY_TY key,
+	const allocator *const a
+)
+{
+#if defined HASHMAP_KEYTYPE
+	(void)a;
+	bkt->key = key;
+	bkt->live = true;
+	return (true);
+#elif defined HASHMAP_INLINE_KEY_SIZE
+	if (key.len <= HASHMAP_INLINE_KEY_SIZE)
+		memcpy(bkt->key.buf, key.buf, key.len);
+	else if (!(bkt->key.mem = BUCKET_METHODNAME(newkey)(key, a)))
+		return (false);
+
+	bkt->key_len = key.len;
+	return (true);
+#elif defined HASHMAP_INTERN
+	/* overflow error. */
+	if ((size_t)key.len > PTRDIFF_MAX - sizeof(*bkt->key))
+		return (false);
+
+	bkt->key = allocator_alloc(a, sizeof(*bkt->key) + key.len);
+	if (!bkt->key)
+		return (false);
+
+	memcpy(bkt->key->bytes, key.buf, key.len);
+	bkt->key->key = (u8mem){.len = key.len, .buf = bkt->key->bytes};
+	bkt->key->hash = bkt->hash;
+	return (true);
+#else
+	bkt->key = BUCKET_METHODNAME(newkey)(key, a);
+	return (bkt->key != NULL);
+#endif /* defined HASHMAP_KEYTYPE */
+}
+
+/*!
+ * @brief free the key of a `Bucket`, the Bucket is unused afterwards.
+ *
+ * @param bkt pointer to the Bucket.
+ * @param a allocator the key came from, NULL for `xmalloc`.
+ */
+static void BUCKET_METHODNAME(freekey)(
+	BUCKET_STRUCT_TAG *const restrict bkt, const allocator *const a
+)
+{
+#if defined HASHMAP_KEYTYPE
+	(void)a;
+	bkt->live = false;
+#elif defined HASHMAP_INLINE_KEY_SIZE
+	if (bkt->key_len > HASHMAP_INLINE_KEY_SIZE)
+	{
+		allocator_release(
+			a, bkt->key.mem, BUCKET_METHODNAME(keysize)(bkt)
+		);
+		bkt->key.mem = NULL;
+	}
+
+	bkt->key_len = 0;
+#else
+	allocator_release(a, bkt->key, BUCKET_METHODNAME(keysize)(bkt));
+	bkt->key = NULL;
+#endif /* defined HASHMAP_KEYTYPE */
+}
+
+/*!
+ * @brief add the key of a live `Bucket` to the counts of the memory used by
+ * keys, or take it away from them.
+ *
+ * @param bkt pointer to the Bucket.
+ * @param bytes count of the bytes allocated for keys.
+ * @param blocks count of the blocks allocated for keys.
+ * @param sign 1 to add the key, -1 to take it away.
+ */
+static void BUCKET_METHODNAME(count_key)(
+	const BUCKET_STRUCT_TAG *const restrict bkt, len_ty *const restrict bytes,
+	len_ty *const restrict blocks, const len_ty sign
+)
+{
+	const len_ty size = BUCKET_METHODNAME(keysize)(bkt);
+
+	if (size < 1)
+		return;
+
+	*bytes += sign * size;
+	*blocks += sign;
+}
+
+/*!
+ * @brief size of the arrays stored after the Buckets of a `HashMap`.
+ *
+ * @param capacity number of Buckets outside the cellar.
+ * @param cellar_capacity number of Buckets in the cellar.
+ * @returns the size in bytes.
+ */
+static size_t HASHMAP_METHODNAME(side_size)(
+	const len_ty capacity, const len_ty cellar_capacity
+)
+{
+	size_t side_size = 0;
+
+#ifdef SWISS_TABLE_PROBING
+	side_size += CTRL_BYTES_SIZE((size_t)capacity);
+#endif /* SWISS_TABLE_PROBING */
+#ifdef HOT_COLD_SPLIT
+	side_size +=
+		sizeof(LINK_STRUCT_TAG) * ((size_t)cellar_capacity + capacity);
+#endif /* HOT_COLD_SPLIT */
+#ifdef OCCUPANCY_BITMAP
+	side_size += BITMAP_SIZE((size_t)cellar_capacity + capacity);
+#endif /* OCCUPANCY_BITMAP */
+	(void)capacity, (void)cellar_capacity;
+	return (side_size);
+}
+
+/*!
+ * @brief size of the block of memory a `HashMap` is stored in.
+ *
+ * @param hm pointer to the HashMap.
+ * @returns the size in bytes.
+ */
+static size_t HASHMAP_METHODNAME(table_size)(
+	const HASHMAP_STRUCT_TAG *const restrict hm
+)
+{
+#ifdef CELLAR_COALESCED_HASHING
+	const len_ty cellar_capacity = hm->cellar.capacity;
+#else
+	const len_ty cellar_capacity = 0;
+#endif /* CELLAR_COALESCED_HASHING */
+
+	return (
+		sizeof(*hm) +
+		sizeof(*hm->arr) * ((size_t)cellar_capacity + hm->capacity) +
+		HASHMAP_METHODNAME(side_size)(hm->capacity, cellar_capacity)
+	);
+}
+
+/*!
+ * @brief allocate the block of memory a `HashMap` is stored in.
+ *
+ * @param size size of the block in bytes.
+ * @param a the allocator, NULL for `xmalloc`.
+ * @returns pointer to the block, NULL on failure. It is zeroed unless the
+ * Buckets are initialised as a stack.
+ */
+static HASHMAP_STRUCT_TAG *
+HASHMAP_METHODNAME(table_alloc)(const size_t size, const allocator *const a)
+{
+#ifdef HASHMAP_HUGE_PAGES
+	if (!a && size >= HASHMAP_HUGE_PAGES_THRESHOLD)
+	{
+	#ifdef HASHMAP_PREFAULT_THREADS
+		return (pages_alloc((len_ty)size, HASHMAP_PREFAULT_THREADS));
+	#else
+		return (pages_alloc((len_ty)size, 0));
+	#endif /* HASHMAP_PREFAULT_THREADS */
+	}
+
+#endif /* HASHMAP_HUGE_PAGES */
+#ifdef EMPTY_BUCKET_STACK
+	return (allocator_alloc(a, (len_ty)size));
+#else
+	return (allocator_calloc(a, (len_ty)size));
+#endif /* EMPTY_BUCKET_STACK */
+}
+
+/*!
+ * @brief free the block of memory a `HashMap` is stored in.
+ *
+ * @param hm pointer to the block.
+ * @param size size the block was allocated with.
+ * @param a the allocator, NULL for `xmalloc`.
+ */
+static void HASHMAP_METHODNAME(table_release)(
+	HASHMAP_STRUCT_TAG *const hm, const size_t size, const allocator *const a
+)
+{
+#ifdef HASHMAP_HUGE_PAGES
+	if (!a && size >= HASHMAP_HUGE_PAGES_THRESHOLD)
+	{
+		pages_release(hm, (len_ty)size);
+		return;
+	}
+
+#endif /* HASHMAP_HUGE_PAGES */
+	allocator_release(a, hm, (len_ty)size);
 }
 
 /**
@@ -100,6 +564,46 @@ static bool BUCKET_METHODNAME(islive)(const BUCKET_STRUCT_TAG bkt)
  * @returns pointer to the hash map success, NULL on failure.
  */
 HASHMAP_STRUCT_TAG *HASHMAP_METHODNAME(new)(len_ty capacity)
+{
+	return (HASHMAP_METHODNAME(new_with_allocator)(capacity, NULL));
+}
+
+/*!
+ * @brief allocate and initialise memory for a `HashMap` with a given seed.
+ *
+ * HashMaps with the same seed hash keys the same way, so a hash computed by
+ * one of them can be passed to the `*_hashed` methods of the others until
+ * one of them is reseeded.
+ *
+ * @param capacity number of buckets the HashMap will contain.
+ * @param seed the seed of the hash function.
+ * @returns pointer to the hash map success, NULL on failure.
+ */
+HASHMAP_STRUCT_TAG *
+HASHMAP_METHODNAME(new_seeded)(len_ty capacity, const uint64_t seed)
+{
+	HASHMAP_STRUCT_TAG *const hm = HASHMAP_METHODNAME(new)(capacity);
+
+	if (hm)
+		hm->seed = seed;
+
+	return (hm);
+}
+
+/*!
+ * @brief allocate and initialise memory for a `HashMap` whose Buckets and
+ * keys come from an `allocator`.
+ *
+ * The allocator is also used by the HashMaps that replace this one when it
+ * grows or shrinks, and by its copies. It must outlive all of them.
+ *
+ * @param capacity number of buckets the HashMap will contain.
+ * @param a the allocator, NULL for `xmalloc`.
+ * @returns pointer to the hash map success, NULL on failure.
+ */
+HASHMAP_STRUCT_TAG *HASHMAP_METHODNAME(new_with_allocator)(
+	len_ty capacity, const allocator *const a
+)
 {
 	if (capacity < 1)
 		return (NULL);
@@ -113,28 +617,39 @@ HASHMAP_STRUCT_TAG *HASHMAP_METHODNAME(new)(len_ty capacity)
 #else
 	const len_ty cellar_capacity = 0;
 #endif /* CELLAR_COALESCED_HASHING */
+	const size_t side_size =
+		HASHMAP_METHODNAME(side_size)(capacity, cellar_capacity);
 	const size_t cellar_size = sizeof(BUCKET_STRUCT_TAG) * cellar_capacity;
 	const size_t size = sizeof(BUCKET_STRUCT_TAG) * capacity;
 
+#if !defined SWISS_TABLE_PROBING && !defined ROBIN_HOOD_HASHING
+	/* Every slot needs a position that fits in the links. */
+	if ((uintmax_t)cellar_capacity + capacity > (pos_ty)-1)
+		return (NULL);
+
+#endif /* !defined SWISS_TABLE_PROBING && !defined ROBIN_HOOD_HASHING */
 	/* overflow errors. */
 	if (SIZE_MAX - cellar_size < size ||
-		SIZE_MAX - (cellar_size + size) < sizeof(HASHMAP_STRUCT_TAG) ||
+		SIZE_MAX - (cellar_size + size) < side_size ||
+		SIZE_MAX - (cellar_size + size + side_size) <
+			sizeof(HASHMAP_STRUCT_TAG) ||
 		(cellar_size + size) / sizeof(BUCKET_STRUCT_TAG) !=
 			((size_t)cellar_capacity + capacity))
 		return (NULL);
 
-#ifdef EMPTY_BUCKET_STACK
-	HASHMAP_STRUCT_TAG *const restrict table =
-		xmalloc(sizeof(*table) + size + cellar_size);
-#else
-	HASHMAP_STRUCT_TAG *const restrict table =
-		xcalloc(1, sizeof(*table) + size + cellar_size);
-#endif /* EMPTY_BUCKET_STACK */
+	HASHMAP_STRUCT_TAG *const restrict table = HASHMAP_METHODNAME(table_alloc)(
+		sizeof(*table) + size + cellar_size + side_size, a
+	);
 
 	if (!table)
 		return (NULL);
 
-	*table = (HASHMAP_STRUCT_TAG){.capacity = capacity};
+	*table = (HASHMAP_STRUCT_TAG){
+		.capacity = capacity, .seed = random_seed(table), .alloc = a
+	};
+#ifdef SWISS_TABLE_PROBING
+	memset(CTRL_BYTES(table), CTRL_EMPTY, side_size);
+#endif /* SWISS_TABLE_PROBING */
 #ifdef CELLAR_COALESCED_HASHING
 	table->cellar = (CELLAR_STRUCT_TAG){.capacity = cellar_capacity};
 #endif /* CELLAR_COALESCED_HASHING */
@@ -149,10 +664,10 @@ HASHMAP_STRUCT_TAG *HASHMAP_METHODNAME(new)(len_ty capacity)
 	#endif /* CELLAR_COALESCED_HASHING */
 	table->top_pos = i;
 	/* top.prev_pos should be 0. */
-	unsigned int prev_pos = 0;
+	pos_ty prev_pos = 0;
 	while (i > 0)
 	{
-		const unsigned int curr_pos = i;
+		const pos_ty curr_pos = i;
 
 		i--;
 		table->arr[i] = (BUCKET_STRUCT_TAG){
@@ -180,6 +695,15 @@ static bool HASHMAP_METHODNAME(isvalid)(const HASHMAP_STRUCT_TAG *const hm)
 #ifdef CELLAR_COALESCED_HASHING
 	ok = ok && hm->cellar.capacity >= 0 && hm->cellar.used >= 0;
 #endif /* CELLAR_COALESCED_HASHING */
+#ifdef SWISS_TABLE_PROBING
+	ok = ok && hm->deleted >= 0;
+#endif /* SWISS_TABLE_PROBING */
+#ifdef OCCUPANCY_BITMAP
+	ok = ok && hm->free_hint >= 0;
+#endif /* OCCUPANCY_BITMAP */
+#ifdef INCREMENTAL_RESIZE
+	ok = ok && hm->old_pos >= 0;
+#endif /* INCREMENTAL_RESIZE */
 	return (ok);
 }
 
@@ -198,6 +722,9 @@ void *HASHMAP_METHODNAME(delete)(
 	if (!hm)
 		return (NULL);
 
+	const allocator *const a = hm->alloc;
+	const size_t size = HASHMAP_METHODNAME(table_size)(hm);
+
 	if (HASHMAP_METHODNAME(isvalid)(hm) == false)
 		goto free_hashmap;
 
@@ -206,6 +733,11 @@ void *HASHMAP_METHODNAME(delete)(
 #ifdef CELLAR_COALESCED_HASHING
 	i += hm->cellar.capacity;
 #endif /* CELLAR_COALESCED_HASHING */
+	/* Keys from an allocator that cannot free go away with the allocator, */
+	/* so without data to free there is nothing to visit. */
+	if (a && !a->release && !data_free)
+		i = 0;
+
 	while (i > 0)
 	{
 		i--;
@@ -215,16 +747,44 @@ void *HASHMAP_METHODNAME(delete)(
 		if (data_free)
 			data_free(hm->arr[i].data);
 
-		hm->arr[i].key = xfree(hm->arr[i].key);
+		BUCKET_METHODNAME(freekey)(&hm->arr[i], a);
 		hm->arr[i] = (BUCKET_STRUCT_TAG){0};
 	}
 
+#ifdef INCREMENTAL_RESIZE
+	HASHMAP_METHODNAME(delete)(hm->old, data_free);
+#endif /* INCREMENTAL_RESIZE */
 free_hashmap:
 	*hm = (HASHMAP_STRUCT_TAG){0};
-	xfree(hm);
+	HASHMAP_METHODNAME(table_release)(hm, size, a);
+	return (NULL);
+}
+
+#if defined HASHMAP_RCU || defined INCREMENTAL_RESIZE
+/*!
+ * @brief free the memory of a HashMap that shares its keys and data with
+ * another HashMap, leaving the keys and data alone.
+ *
+ * @param hm pointer to the HashMap to free.
+ * @returns NULL always.
+ */
+static void *HASHMAP_METHODNAME(release)(HASHMAP_STRUCT_TAG *const restrict hm)
+{
+	const allocator *const a = hm->alloc;
+	const size_t size = HASHMAP_METHODNAME(table_size)(hm);
+
+	#ifdef INCREMENTAL_RESIZE
+	if (hm->old)
+		HASHMAP_METHODNAME(release)(hm->old);
+
+	#endif /* INCREMENTAL_RESIZE */
+	*hm = (HASHMAP_STRUCT_TAG){0};
+	HASHMAP_METHODNAME(table_release)(hm, size, a);
 	return (NULL);
 }
 
+#endif /* defined HASHMAP_RCU || defined INCREMENTAL_RESIZE */
+
 /*!
  * @brief duplicate a `HashMap`.
  *
@@ -245,8 +805,28 @@ HASHMAP_STRUCT_TAG *HASHMAP_METHODNAME(copy)(
 		(data_dup && !data_free))
 		return (NULL);
 
+	return (HASHMAP_METHODNAME(copy_table)(hm, data_dup, data_free, false));
+}
+
+/*!
+ * @brief duplicate the Buckets of a `HashMap`.
+ *
+ * @param hm pointer to the HashMap to duplicate.
+ * @param data_dup function that can duplicate the data in the HashMap.
+ * @param data_free function that can delete the data in the HashMap.
+ * @param share_keys true to share the keys and data with `hm` instead of
+ * duplicating them, `data_dup` must then be NULL. The duplicate is freed
+ * with `release`.
+ * @returns pointer to the duplicate HashMap, NULL on error.
+ */
+static HASHMAP_STRUCT_TAG *HASHMAP_METHODNAME(copy_table)(
+	const HASHMAP_STRUCT_TAG *const restrict hm,
+	HM_CONCAT(duplicate_, HASHMAP_UNIQUE_SUFFIX) data_dup,
+	HM_CONCAT(free_mem_, HASHMAP_UNIQUE_SUFFIX) data_free, const bool share_keys
+)
+{
 	HASHMAP_STRUCT_TAG *const restrict cpy =
-		HASHMAP_METHODNAME(new)(hm->capacity);
+		HASHMAP_METHODNAME(new_with_allocator)(hm->capacity, hm->alloc);
 
 	if (!cpy)
 		return (NULL);
@@ -254,18 +834,22 @@ HASHMAP_STRUCT_TAG *HASHMAP_METHODNAME(copy)(
 	len_ty i = hm->capacity;
 
 #ifdef CELLAR_COALESCED_HASHING
-	i += hm->capacity;
+	i += hm->cellar.capacity;
 #endif /* CELLAR_COALESCED_HASHING */
 	while (i > 0)
 	{
 		i--;
 		cpy->arr[i] = hm->arr[i];
-		if (BUCKET_METHODNAME(islive)(hm->arr[i]) == true)
+		if (!share_keys && BUCKET_METHODNAME(islive)(hm->arr[i]) == true)
 		{
-			cpy->arr[i].key =
-				u8mem_new(hm->arr[i].key->buf, hm->arr[i].key->len);
-			if (!cpy->arr[i].key)
+			if (!BUCKET_METHODNAME(setkey)(
+					&cpy->arr[i], BUCKET_METHODNAME(getkey)(&hm->arr[i]),
+					cpy->alloc
+				))
+			{
+				cpy->arr[i] = (BUCKET_STRUCT_TAG){0};
 				return (HASHMAP_METHODNAME(delete)(cpy, data_free));
+			}
 
 			if (data_dup &&
 				data_dup(&cpy->arr[i].data, hm->arr[i].data) == false)
@@ -273,32 +857,129 @@ HASHMAP_STRUCT_TAG *HASHMAP_METHODNAME(copy)(
 		}
 	}
 
+	cpy->used = hm->used;
+	cpy->key_bytes = hm->key_bytes;
+	cpy->key_blocks = hm->key_blocks;
+	cpy->seed = hm->seed;
+	cpy->long_chain = hm->long_chain;
+	cpy->reseeded = hm->reseeded;
+#ifdef CELLAR_COALESCED_HASHING
+	cpy->cellar.used = hm->cellar.used;
+#endif /* CELLAR_COALESCED_HASHING */
+#ifdef EMPTY_BUCKET_STACK
+	cpy->top_pos = hm->top_pos;
+#endif /* EMPTY_BUCKET_STACK */
+#ifdef SWISS_TABLE_PROBING
+	cpy->deleted = hm->deleted;
+	memcpy(CTRL_BYTES(cpy), CTRL_BYTES(hm), CTRL_BYTES_SIZE(hm->capacity));
+#endif /* SWISS_TABLE_PROBING */
+#ifdef HOT_COLD_SPLIT
+	memcpy(LINKS(cpy), LINKS(hm), sizeof(LINK_STRUCT_TAG) * SLOT_COUNT(hm));
+#endif /* HOT_COLD_SPLIT */
+#ifdef OCCUPANCY_BITMAP
+	memcpy(
+		OCCUPANCY(cpy), OCCUPANCY(hm),
+		(SLOT_COUNT(hm) + BITMAP_WORD_BIT - 1) / BITMAP_WORD_BIT *
+			sizeof(bitmap_word)
+	);
+	cpy->free_hint = hm->free_hint;
+#endif /* OCCUPANCY_BITMAP */
+#ifdef INCREMENTAL_RESIZE
+	if (hm->old)
+	{
+		cpy->old = HASHMAP_METHODNAME(copy_table)(
+			hm->old, data_dup, data_free, share_keys
+		);
+		if (!cpy->old && share_keys)
+			return (HASHMAP_METHODNAME(release)(cpy));
+
+		if (!cpy->old)
+			return (HASHMAP_METHODNAME(delete)(cpy, data_free));
+
+		cpy->old_pos = hm->old_pos;
+	}
+
+#endif /* INCREMENTAL_RESIZE */
 	return (cpy);
 }
 
 /*!
  * @brief calculate the hash value of a given key.
  *
+ * The hash depends on the seed of the HashMap, it is only valid for that
+ * HashMap, or HashMaps with the same seed, and while its `seed` is
+ * unchanged. `insert`, `insert_batch` and `intern` change the seed when they
+ * reseed the HashMap.
+ *
+ * @param hm the HashMap the hash is for.
  * @param dest address to store the hash.
  * @param key block of memory to hash.
  * @returns true on success, false otherwise.
  */
-bool HASHMAP_METHODNAME(hash)(hash_ty *const restrict dest, const u8mem key)
+bool HASHMAP_METHODNAME(hash)(
+	const HASHMAP_STRUCT_TAG *const restrict hm, hash_ty *const restrict dest,
+	const KEY_TY key
+)
 {
-	if (!dest || !key.buf || key.len < 1)
+	if (!hm || HASHMAP_METHODNAME(isvalid)(hm) == false || !dest ||
+		!KEY_ISVALID(key))
 		return (false);
 
-#ifdef FNV32A_HASH_FUNC
+	*dest = HASHMAP_METHODNAME(hash_key)(hm->seed, key);
+	return (true);
+}
+
+/*!
+ * @brief calculate the hash value of a key with a seed.
+ *
+ * @param seed the seed of the hash function.
+ * @param key block of memory to hash, must not be empty.
+ * @returns the hash.
+ */
+static hash_ty
+HASHMAP_METHODNAME(hash_key)(const uint64_t seed, const KEY_TY key)
+{
+#if defined HASHMAP_KEY_HASH
+	return ((hash_ty)HASHMAP_KEY_HASH(key, seed));
+#elif defined HASHMAP_KEYTYPE
+	/* The mixer is a bijection of 64 bit integers, but keeping only the low */
+	/* half for a 32 bit `hash_ty` lets distinct keys share a hash. */
+	return ((hash_ty)seed_mix((uint64_t)key ^ seed));
+#elif defined RUNTIME_HASH_FUNC || defined WYHASH_HASH_FUNC
+	/* 32 bit hashes keep the low half of the 64 bit hash. */
+	uint64_t hash = seed;
+
+	#ifdef RUNTIME_HASH_FUNC
+	hash_dispatch(key.buf, key.len, &hash);
+	#else
+	wyhash(key.buf, key.len, &hash);
+	#endif /* RUNTIME_HASH_FUNC */
+	return ((hash_ty)hash);
+#elif defined FNV64A_HASH_FUNC
+	// FNV-1 and FNV-1a 64 bit non-zero initial basis.
+	uint64_t hash = 0xcbf29ce484222325ULL ^ seed;
+
+	fnv64a_hash(key.buf, key.len, &hash);
+	return (hash);
+#elif defined FNV32A_HASH_FUNC
 	// FNV-1 and FNV-1a 32 bit non-zero initial basis.
 	// FNV-0 uses 0 as the the initial value.
-	*dest = 0x811c9dc5U;
-	fnv32a_hash(key.buf, key.len, dest);
+	uint32_t hash = 0x811c9dc5U ^ (uint32_t)seed;
+
+	fnv32a_hash(key.buf, key.len, &hash);
+	return (hash);
+#elif defined MURMURHASH3_x64_128_HASH_FUNC
+	/* The first half of the 128 bit hash. */
+	uint64_t hash[2] = {seed};
+
+	murmurhash3_x64_128(key.buf, key.len, hash);
+	return (hash[0]);
 #elif defined MURMURHASH3_x86_32_HASH_FUNC
-	*dest = 0;
-	murmurhash3_x86_32(key.buf, key.len, dest);
-#endif
+	uint32_t hash = (uint32_t)seed;
 
-	return (true);
+	murmurhash3_x86_32(key.buf, key.len, &hash);
+	return (hash);
+#endif
 }
 
 /*!
@@ -307,55 +988,286 @@ bool HASHMAP_METHODNAME(hash)(hash_ty *const restrict dest, const u8mem key)
  * @param hm the HashMap to search.
  * @param hash the hash to search for.
  * @param key the key to search for.
+ * @param slot address to store the slot to `place` the key from if it is
+ * not found, -1 if there are no free slots. Can be NULL.
  * @returns pointer to the bucket if found, NULL if not found.
  */
 static BUCKET_STRUCT_TAG *HASHMAP_METHODNAME(search_key)(
-	HASHMAP_STRUCT_TAG *const hm, const hash_ty hash, const u8mem key
+	HASHMAP_STRUCT_TAG *const hm, const hash_ty hash, const KEY_TY key,
+	len_ty *const slot
 )
 {
-	const unsigned int index = FOLD(hash, hm->capacity);
-	BUCKET_STRUCT_TAG *restrict walk = &hm->arr[index];
+	if (slot)
+		*slot = -1;
 
-	if (BUCKET_METHODNAME(islive)(*walk) == false)
-		return (NULL);
+#if defined SWISS_TABLE_PROBING
+	const unsigned char *const restrict ctrl = CTRL_BYTES(hm);
+	const unsigned char tag = HASH_TAG(hash);
+	len_ty pos = FOLD(hash, hm->capacity);
 
-	while (walk)
+	for (len_ty probed = 0; probed < hm->capacity; probed += CTRL_GROUP_WIDTH)
 	{
-		if (hash == walk->hash && u8mem_compare(key, *walk->key) == 0)
-			return (walk);
+		if (probed >= HASHMAP_RESEED_CHAIN)
+			hm->long_chain = true;
 
-		walk = POS_TO_PTR(hm->arr, walk->next_pos);
+		for (ctrl_mask match = ctrl_group_match(&ctrl[pos], tag); match;
+			 match &= match - 1)
+		{
+			const len_ty i =
+				(pos + ctrl_mask_trailing_zeros(match)) % hm->capacity;
+
+			if (hash == hm->arr[i].hash &&
+				KEY_EQ(key, BUCKET_METHODNAME(getkey)(&hm->arr[i])))
+				return (&hm->arr[i]);
+		}
+
+		if (slot && *slot < 0)
+		{
+			const ctrl_mask free_slots = ctrl_group_match_free(&ctrl[pos]);
+
+			if (free_slots)
+				*slot = (pos + ctrl_mask_trailing_zeros(free_slots)) %
+						hm->capacity;
+		}
+
+		/* The key would have been placed in this group's empty slot. */
+		if (ctrl_group_match_empty(&ctrl[pos]))
+			return (NULL);
+
+		pos = (pos + CTRL_GROUP_WIDTH) % hm->capacity;
 	}
 
 	return (NULL);
-}
+#elif defined ROBIN_HOOD_HASHING
+	len_ty pos = FOLD(hash, hm->capacity);
 
-/*!
- * @brief search for a `Bucket` with the same key as the given key.
- *
- * @param hm the HashMap to search.
- * @param key the key to search for.
- * @returns pointer to the data in the Bucket with the same key, NULL on
- * failure.
- */
-HASHMAP_DATATYPE *
-HASHMAP_METHODNAME(search)(HASHMAP_STRUCT_TAG *const hm, const u8mem key)
-{
-	if (HASHMAP_METHODNAME(isvalid)(hm) == false)
-		return (NULL);
+	/* The key would have displaced any Bucket closer to its home slot. */
+	for (len_ty distance = 0; distance < hm->capacity; distance++)
+	{
+		if (distance == HASHMAP_RESEED_CHAIN)
+			hm->long_chain = true;
 
-	hash_ty hash;
+		if (BUCKET_METHODNAME(islive)(hm->arr[pos]) == false ||
+			HASHMAP_METHODNAME(probe_distance)(hm, pos) < distance)
+		{
+			if (slot)
+				*slot = pos;
 
-	if (!HASHMAP_METHODNAME(hash)(&hash, key))
-		return (NULL);
+			return (NULL);
+		}
 
-	BUCKET_STRUCT_TAG *const restrict bucket =
-		HASHMAP_METHODNAME(search_key)(hm, hash, key);
+		if (hash == hm->arr[pos].hash &&
+			KEY_EQ(key, BUCKET_METHODNAME(getkey)(&hm->arr[pos])))
+			return (&hm->arr[pos]);
 
-	if (!bucket)
-		return (NULL);
+		pos = pos + 1 < hm->capacity ? pos + 1 : 0;
+	}
 
-	return (&bucket->data);
+	return (NULL);
+#else
+	const len_ty index = FOLD(hash, hm->capacity);
+	BUCKET_STRUCT_TAG *restrict walk = &hm->arr[index];
+	BUCKET_STRUCT_TAG *restrict tail = walk;
+	len_ty walked = 0;
+
+	#ifdef HOT_COLD_SPLIT
+	/* Unused Buckets have zeroed Links, so only the Links are read until */
+	/* a hash matches. */
+	while (walk)
+	{
+		if (hash == HASH_OF(hm, walk) &&
+			BUCKET_METHODNAME(islive)(*walk) == true &&
+			KEY_EQ(key, BUCKET_METHODNAME(getkey)(walk)))
+			return (walk);
+
+		if (++walked == HASHMAP_RESEED_CHAIN)
+			hm->long_chain = true;
+
+		tail = walk;
+		walk = POS_TO_PTR(hm->arr, NEXT_POS(hm, walk));
+	}
+	#else
+	if (BUCKET_METHODNAME(islive)(*walk) == true)
+	{
+		while (walk)
+		{
+			if (hash == walk->hash &&
+				KEY_EQ(key, BUCKET_METHODNAME(getkey)(walk)))
+				return (walk);
+
+			if (++walked == HASHMAP_RESEED_CHAIN)
+				hm->long_chain = true;
+
+			tail = walk;
+			walk = POS_TO_PTR(hm->arr, walk->next_pos);
+		}
+	}
+	#endif /* HOT_COLD_SPLIT */
+
+	/* New Buckets are linked after the end of the chain. */
+	if (slot)
+		*slot = tail - hm->arr;
+
+	return (NULL);
+#endif /* defined SWISS_TABLE_PROBING */
+}
+
+/*!
+ * @brief search for a `Bucket` with the same key as the given key.
+ *
+ * @param hm the HashMap to search.
+ * @param key the key to search for.
+ * @returns pointer to the data in the Bucket with the same key, NULL on
+ * failure.
+ */
+HASHMAP_DATATYPE *
+HASHMAP_METHODNAME(search)(HASHMAP_STRUCT_TAG *const hm, const KEY_TY key)
+{
+	if (HASHMAP_METHODNAME(isvalid)(hm) == false)
+		return (NULL);
+
+	hash_ty hash;
+
+	if (!HASHMAP_METHODNAME(hash)(hm, &hash, key))
+		return (NULL);
+
+	return (HASHMAP_METHODNAME(search_hashed)(hm, hash, key));
+}
+
+/*!
+ * @brief search for a `Bucket` with the same key as the given key.
+ *
+ * @param hm the HashMap to search.
+ * @param hash hash of the key, as returned by `hash` for this HashMap under
+ * its current `seed`. A hash from another HashMap is only valid if both
+ * have the same seed, see `new_seeded`.
+ * @param key the key to search for.
+ * @returns pointer to the data in the Bucket with the same key, NULL on
+ * failure.
+ */
+HASHMAP_DATATYPE *HASHMAP_METHODNAME(search_hashed)(
+	HASHMAP_STRUCT_TAG *const hm, const hash_ty hash, const KEY_TY key
+)
+{
+	if (HASHMAP_METHODNAME(isvalid)(hm) == false || !KEY_ISVALID(key))
+		return (NULL);
+
+#ifdef INCREMENTAL_RESIZE
+	HASHMAP_METHODNAME(migrate)(hm, HASHMAP_MIGRATE_STEP);
+#endif /* INCREMENTAL_RESIZE */
+	BUCKET_STRUCT_TAG *restrict bucket =
+		HASHMAP_METHODNAME(search_key)(hm, hash, key, NULL);
+
+#ifdef INCREMENTAL_RESIZE
+	if (!bucket && hm->old)
+		bucket = HASHMAP_METHODNAME(search_key)(hm->old, hash, key, NULL);
+
+#endif /* INCREMENTAL_RESIZE */
+	if (!bucket)
+		return (NULL);
+
+	return (&bucket->data);
+}
+
+#ifdef HASHMAP_INTERN
+/*!
+ * @brief search for the `Bucket` of an interned key.
+ *
+ * The cached hash of the handle is used and the key is matched by address,
+ * so the key is neither hashed nor compared byte by byte.
+ *
+ * @param hm the HashMap the handle was interned in.
+ * @param handle the handle, as returned by `intern`.
+ * @returns pointer to the data in the Bucket of the key, NULL on failure.
+ */
+HASHMAP_DATATYPE *HASHMAP_METHODNAME(search_interned)(
+	HASHMAP_STRUCT_TAG *const hm,
+	const INTERNED_STRUCT_TAG *const restrict handle
+)
+{
+	if (!handle)
+		return (NULL);
+
+	return (HASHMAP_METHODNAME(search_hashed)(hm, handle->hash, handle->key));
+}
+
+#endif /* HASHMAP_INTERN */
+/*!
+ * @brief search for the data of several keys.
+ *
+ * The keys are handled `HASHMAP_BATCH_GROUP` at a time, every key in a group
+ * is hashed and has its home slot prefetched before any of them is searched
+ * so that the cache misses of the group overlap.
+ *
+ * @param hm the HashMap to search.
+ * @param keys array of the keys to search for.
+ * @param n number of keys.
+ * @param out array of `n` pointers, set to the data of each key or NULL if
+ * the key was not found. The pointers stay valid until the HashMap is next
+ * modified.
+ * @returns true on success, false on failure.
+ */
+bool HASHMAP_METHODNAME(search_batch)(
+	HASHMAP_STRUCT_TAG *const hm, const KEY_TY *const restrict keys,
+	const len_ty n, HASHMAP_DATATYPE **const restrict out
+)
+{
+	if (!hm || HASHMAP_METHODNAME(isvalid)(hm) == false || n < 0 ||
+		(n > 0 && (!keys || !out)))
+		return (false);
+
+	hash_ty hashes[HASHMAP_BATCH_GROUP];
+	bool hashed[HASHMAP_BATCH_GROUP];
+
+#ifdef INCREMENTAL_RESIZE
+	/* Once only, migrating between groups would move found Buckets. */
+	HASHMAP_METHODNAME(migrate)(hm, HASHMAP_MIGRATE_STEP);
+#endif /* INCREMENTAL_RESIZE */
+	for (len_ty start = 0; start < n; start += HASHMAP_BATCH_GROUP)
+	{
+		const len_ty group =
+			n - start < HASHMAP_BATCH_GROUP ? n - start : HASHMAP_BATCH_GROUP;
+
+		for (len_ty i = 0; i < group; i++)
+		{
+			hashed[i] =
+				HASHMAP_METHODNAME(hash)(hm, &hashes[i], keys[start + i]);
+			if (!hashed[i])
+				continue;
+
+			const len_ty home = FOLD(hashes[i], hm->capacity);
+
+#if defined SWISS_TABLE_PROBING
+			PREFETCH(&CTRL_BYTES(hm)[home]);
+#elif defined HOT_COLD_SPLIT
+			PREFETCH(&LINKS(hm)[home]);
+#endif /* defined SWISS_TABLE_PROBING */
+#ifndef HOT_COLD_SPLIT
+			PREFETCH(&hm->arr[home]);
+#endif /* HOT_COLD_SPLIT */
+		}
+
+		for (len_ty i = 0; i < group; i++)
+		{
+			BUCKET_STRUCT_TAG *restrict bucket = NULL;
+
+			if (hashed[i])
+				bucket = HASHMAP_METHODNAME(search_key)(
+					hm, hashes[i], keys[start + i], NULL
+				);
+
+#ifdef INCREMENTAL_RESIZE
+			if (!bucket && hashed[i] && hm->old)
+				bucket = HASHMAP_METHODNAME(search_key)(
+					hm->old, hashes[i], keys[start + i], NULL
+				);
+
+#endif /* INCREMENTAL_RESIZE */
+			out[start + i] = bucket ? &bucket->data : NULL;
+		}
+	}
+
+	return (true);
 }
 
 /*!
@@ -375,17 +1287,100 @@ HASHMAP_STRUCT_TAG *HASHMAP_METHODNAME(grow)(
 	if (capacity <= hm->capacity)
 		return (hm);
 
+	return (HASHMAP_METHODNAME(rehash)(hm, capacity));
+}
+
+/*!
+ * @brief shrink the capacity of a `HashMap` to the given capacity.
+ *
+ * The capacity is raised to the smallest one that holds the keys without
+ * going over the maximum load factor.
+ *
+ * @param hm pointer to the HashMap.
+ * @param capacity the new capacity.
+ * @returns pointer to the shrunk HashMap, NULL on failure.
+ */
+HASHMAP_STRUCT_TAG *HASHMAP_METHODNAME(shrink)(
+	HASHMAP_STRUCT_TAG *const restrict hm, len_ty capacity
+)
+{
+	if (!hm || capacity < 1 || HASHMAP_METHODNAME(isvalid)(hm) == false)
+		return (NULL);
+
+	const len_ty needed =
+		(len_ty)(HASHMAP_METHODNAME(count)(hm) / HASHMAP_MAX_LOAD_FACTOR) + 1;
+
+	if (capacity < needed)
+		capacity = needed;
+
+#ifdef POWER2_ROUNDUP_FUNC
+	capacity = power2_roundup(capacity);
+#endif /* POWER2_ROUNDUP_FUNC */
+	if (capacity >= hm->capacity)
+		return (hm);
+
+	return (HASHMAP_METHODNAME(rehash)(hm, capacity));
+}
+
+/*!
+ * @brief shrink a `HashMap` that removals have left sparse.
+ *
+ * A HashMap under `HASHMAP_MIN_LOAD_FACTOR` is shrunk to
+ * `HASHMAP_SHRINK_LOAD_FACTOR`. Doubling the capacity also leaves it well
+ * above the minimum, so keys coming and going around either limit do not
+ * resize it every time.
+ *
+ * @param hm pointer to the HashMap.
+ * @returns pointer to the trimmed HashMap, NULL on failure.
+ */
+HASHMAP_STRUCT_TAG *HASHMAP_METHODNAME(trim)(HASHMAP_STRUCT_TAG *const hm)
+{
+	if (!hm || HASHMAP_METHODNAME(isvalid)(hm) == false)
+		return (NULL);
+
+	const len_ty keys = HASHMAP_METHODNAME(count)(hm);
+
+	if (hm->capacity <= HASHMAP_MIN_TRIM_CAPACITY ||
+		keys >= HASHMAP_MIN_LOAD_FACTOR * hm->capacity)
+		return (hm);
+
+	const len_ty capacity = (len_ty)(keys / HASHMAP_SHRINK_LOAD_FACTOR) + 1;
+
+	return (HASHMAP_METHODNAME(shrink)(
+		hm, capacity > HASHMAP_MIN_TRIM_CAPACITY ? capacity
+												 : HASHMAP_MIN_TRIM_CAPACITY
+	));
+}
+
+/*!
+ * @brief move the Buckets of a `HashMap` into a new HashMap.
+ *
+ * @param hm pointer to the HashMap, it is deleted on success.
+ * @param capacity capacity of the new HashMap, must fit all the Buckets.
+ * @returns pointer to the new HashMap, NULL on failure.
+ */
+static HASHMAP_STRUCT_TAG *HASHMAP_METHODNAME(rehash)(
+	HASHMAP_STRUCT_TAG *const restrict hm, const len_ty capacity
+)
+{
+#ifdef INCREMENTAL_RESIZE
+	HASHMAP_METHODNAME(migrate)(hm, LEN_TY_max);
+#endif /* INCREMENTAL_RESIZE */
 #ifdef POWER2_ROUNDUP_FUNC
 	HASHMAP_STRUCT_TAG *const restrict new_hm =
-		HASHMAP_METHODNAME(new)(power2_roundup(capacity));
+		HASHMAP_METHODNAME(new_with_allocator)(
+			power2_roundup(capacity), hm->alloc
+		);
 #else
 	HASHMAP_STRUCT_TAG *const restrict new_hm =
-		HASHMAP_METHODNAME(new)(capacity);
+		HASHMAP_METHODNAME(new_with_allocator)(capacity, hm->alloc);
 #endif /* POWER2_ROUNDUP_FUNC */
 
 	if (!new_hm)
 		return (NULL);
 
+	/* The stored hashes stay valid with the same seed. */
+	new_hm->seed = hm->seed;
 	len_ty i = hm->capacity;
 
 #ifdef CELLAR_COALESCED_HASHING
@@ -398,7 +1393,10 @@ HASHMAP_STRUCT_TAG *HASHMAP_METHODNAME(grow)(
 			continue;
 
 		/* slots should not run out. */
-		HASHMAP_METHODNAME(place)(new_hm, hm->arr[i]);
+		HASHMAP_METHODNAME(place)(
+			new_hm, hm->arr[i],
+			HASHMAP_METHODNAME(find_slot)(new_hm, hm->arr[i].hash)
+		);
 		hm->arr[i] = (BUCKET_STRUCT_TAG){0};
 	}
 
@@ -406,390 +1404,3151 @@ HASHMAP_STRUCT_TAG *HASHMAP_METHODNAME(grow)(
 	return (new_hm);
 }
 
+#ifdef HASHMAP_PARALLEL_GROW
 /*!
- * @brief double the capacity of a `HashMap` if needed.
+ * @brief the share of a parallel grow or build done by one thread.
  *
- * @param hm pointer to the HashMap to grow.
- * @returns pointer to the doubled HashMap, NULL on failure.
+ * Buckets are first sorted by the region of the new slots their home slot
+ * is in, then each thread places the Buckets of a run of regions using only
+ * the slots of those regions.
  */
-static HASHMAP_STRUCT_TAG *
-HASHMAP_METHODNAME(double_capacity)(HASHMAP_STRUCT_TAG *const restrict hm)
+struct GROW_TASK_STRUCT_TAG
 {
-#ifdef CELLAR_COALESCED_HASHING
-	if (hm->cellar.used < hm->cellar.capacity)
-		return (hm);
-#endif /* CELLAR_COALESCED_HASHING */
+	/*! HashMap being grown, the sorted Buckets are cleared from it. */
+	HASHMAP_STRUCT_TAG *restrict hm;
+	/*! HashMap the Buckets are moved to. */
+	HASHMAP_STRUCT_TAG *restrict new_hm;
+	/*! keys to build the HashMap from, instead of the Buckets of `hm`. */
+	const KEY_TY *restrict keys;
+	/*! data of the keys. */
+	HASHMAP_DATATYPE const *restrict values;
+	/*! hashes of the keys. */
+	hash_ty *restrict hashes;
+	/*! number of new slots in a region. */
+	len_ty region_size;
+	/*! first slot of `hm` or key to sort, or slot of `new_hm` to place */
+	/*! Buckets in. */
+	len_ty begin;
+	/*! slot or key after the last one to sort or place Buckets in. */
+	len_ty end;
+	/*! the live Buckets of the slots to sort counted per region, then the */
+	/*! index in `sorted` of the next Bucket of each region. */
+	len_ty *restrict offsets;
+	/*! the sorted Buckets, NULL while counting. When placing, the Buckets */
+	/*! of the task, those that did not fit are moved to the front. */
+	BUCKET_STRUCT_TAG *sorted;
+	/*! index in the sorted Buckets where each region starts. */
+	const len_ty *restrict starts;
+	/*! first region to place Buckets in. */
+	len_ty first;
+	/*! region after the last one to place Buckets in. */
+	len_ty last;
+	/*! index of the Buckets seen in a region, NULL if keys are unique. */
+	len_ty *restrict seen;
+	/*! `seen` has `seen_mask + 1` entries, a power of 2. */
+	len_ty seen_mask;
+	/*! number of Buckets left after dropping the repeated keys. */
+	len_ty kept;
+	/*! number of Buckets that did not fit. */
+	len_ty count;
+	/*! bytes allocated for the keys of the Buckets that fit. */
+	len_ty key_bytes;
+	/*! number of blocks allocated for the keys of the Buckets that fit. */
+	len_ty key_blocks;
+	/*! true if a key was invalid or could not be copied. */
+	bool failed;
+};
 
-	if (hm->used <= HASHMAP_MAX_LOAD_FACTOR * hm->capacity)
-		return (hm);
+/*!
+ * @brief count or sort the live Buckets in a range of slots by the region of
+ * the new HashMap their home slots are in.
+ *
+ * @param arg pointer to a `GrowTask`.
+ * @returns 0 always.
+ */
+static int HASHMAP_METHODNAME(grow_sort_task)(void *const arg)
+{
+	struct GROW_TASK_STRUCT_TAG *const restrict task = arg;
+	HASHMAP_STRUCT_TAG *const restrict hm = task->hm;
 
-	HASHMAP_STRUCT_TAG *const restrict new_hm =
-		HASHMAP_METHODNAME(grow)(hm, hm->capacity * 2);
+	for (len_ty i = task->begin; i < task->end; i++)
+	{
+		if (BUCKET_METHODNAME(islive)(hm->arr[i]) == false)
+			continue;
 
-	return (new_hm);
+		const len_ty home = FOLD(hm->arr[i].hash, task->new_hm->capacity);
+		const len_ty region = home / task->region_size;
+
+		if (task->sorted)
+		{
+			task->sorted[task->offsets[region]++] = hm->arr[i];
+			hm->arr[i] = (BUCKET_STRUCT_TAG){0};
+		}
+		else
+			task->offsets[region]++;
+	}
+
+	return (0);
+}
+
+/*!
+ * @brief hash and count, or sort, a range of keys by the region of the new
+ * HashMap their home slots are in.
+ *
+ * @param arg pointer to a `GrowTask`.
+ * @returns 0 always.
+ */
+static int HASHMAP_METHODNAME(pairs_sort_task)(void *const arg)
+{
+	struct GROW_TASK_STRUCT_TAG *const restrict task = arg;
+	HASHMAP_STRUCT_TAG *const restrict hm = task->new_hm;
+
+	for (len_ty i = task->begin; i < task->end; i++)
+	{
+		if (!task->sorted)
+		{
+			if (!KEY_ISVALID(task->keys[i]))
+			{
+				task->failed = true;
+				continue;
+			}
+
+			task->hashes[i] =
+				HASHMAP_METHODNAME(hash_key)(hm->seed, task->keys[i]);
+		}
+
+		const len_ty home = FOLD(task->hashes[i], hm->capacity);
+		const len_ty region = home / task->region_size;
+
+		if (task->sorted)
+		{
+			BUCKET_STRUCT_TAG *const restrict bucket =
+				&task->sorted[task->offsets[region]++];
+
+			/* A Bucket whose key could not be copied is left unused. */
+			*bucket = (BUCKET_STRUCT_TAG){
+				.data = task->values[i], .hash = task->hashes[i]
+			};
+			if (!BUCKET_METHODNAME(setkey)(bucket, task->keys[i], hm->alloc))
+				task->failed = true;
+		}
+		else
+			task->offsets[region]++;
+	}
+
+	return (0);
+}
+
+/*!
+ * @brief insert a `Bucket` into a `HashMap` using only the slots in a range.
+ *
+ * The slots outside the range may be in use by other threads, so they are
+ * never read. The range must hold the home slot of the Bucket.
+ *
+ * @param hm pointer to the HashMap.
+ * @param bucket the Bucket to insert. With Robin Hood hashing it may be
+ * swapped for a Bucket it displaced, which is then the one that did not fit.
+ * @param end slot after the last one of the range.
+ * @returns true if the Bucket was inserted, false if it did not fit.
+ */
+static bool HASHMAP_METHODNAME(place_in_range)(
+	HASHMAP_STRUCT_TAG *const restrict hm,
+	BUCKET_STRUCT_TAG *const restrict bucket, const len_ty end
+)
+{
+	len_ty pos = FOLD(bucket->hash, hm->capacity);
+
+	#if defined SWISS_TABLE_PROBING
+	/* The first free slot from home is the first of the first group with */
+	/* one, so lookups find the Bucket as if `find_slot` had picked it. */
+	for (; pos < end; pos++)
+	{
+		if (CTRL_BYTES(hm)[pos] == CTRL_EMPTY)
+		{
+			HASHMAP_METHODNAME(set_ctrl)(hm, pos, HASH_TAG(bucket->hash));
+			hm->arr[pos] = *bucket;
+			return (true);
+		}
+	}
+	#elif defined ROBIN_HOOD_HASHING
+	/* Long probes are left to `place` so that they are noticed. */
+	for (len_ty distance = 0; pos < end && distance < HASHMAP_RESEED_CHAIN;
+		 pos++, distance++)
+	{
+		if (BUCKET_METHODNAME(islive)(hm->arr[pos]) == false)
+		{
+			hm->arr[pos] = *bucket;
+			return (true);
+		}
+
+		const len_ty pos_distance = HASHMAP_METHODNAME(probe_distance)(hm, pos);
+
+		if (pos_distance < distance)
+		{
+			const BUCKET_STRUCT_TAG displaced = hm->arr[pos];
+
+			hm->arr[pos] = *bucket;
+			*bucket = displaced;
+			distance = pos_distance;
+		}
+	}
+	#else
+	/* Only unchained Buckets are placed, chains need slots from anywhere. */
+	if (pos < end && BUCKET_METHODNAME(islive)(hm->arr[pos]) == false)
+	{
+		#ifndef HOT_COLD_SPLIT
+		bucket->next_pos = 0;
+		#endif /* HOT_COLD_SPLIT */
+		bucket->prev_pos = 0;
+		hm->arr[pos] = *bucket;
+		#ifdef HOT_COLD_SPLIT
+		LINKS(hm)[pos] = (LINK_STRUCT_TAG){.hash = bucket->hash};
+		#endif /* HOT_COLD_SPLIT */
+		#ifdef OCCUPANCY_BITMAP
+		bitmap_set(OCCUPANCY(hm), pos);
+		#endif /* OCCUPANCY_BITMAP */
+		return (true);
+	}
+	#endif /* defined SWISS_TABLE_PROBING */
+
+	return (false);
+}
+
+/*!
+ * @brief drop the Buckets of a region whose keys come again later in it.
+ *
+ * The data of the last Bucket with a key is kept, in the first Bucket with
+ * that key.
+ *
+ * @param task the `GrowTask` of the region.
+ * @param region the Buckets of the region, in the order of their keys.
+ * @param count number of Buckets in the region.
+ * @returns number of Buckets left, at the front of `region`.
+ */
+static len_ty HASHMAP_METHODNAME(dedup_region)(
+	struct GROW_TASK_STRUCT_TAG *const restrict task,
+	BUCKET_STRUCT_TAG *const restrict region, const len_ty count
+)
+{
+	len_ty *const restrict seen = task->seen;
+	len_ty kept = 0;
+
+	memset(seen, 0, sizeof(*seen) * (task->seen_mask + 1));
+	for (len_ty i = 0; i < count; i++)
+	{
+		/* The low bits of the hash also pick the home slot, mix the high */
+		/* bits in so the Buckets of a region spread out. */
+		len_ty pos = (len_ty)(region[i].hash ^ (region[i].hash >> 16)) &
+					 task->seen_mask;
+		const KEY_TY key = BUCKET_METHODNAME(getkey)(&region[i]);
+
+		for (; seen[pos]; pos = (pos + 1) & task->seen_mask)
+		{
+			BUCKET_STRUCT_TAG *const restrict first = &region[seen[pos] - 1];
+
+			if (first->hash == region[i].hash &&
+				KEY_EQ(key, BUCKET_METHODNAME(getkey)(first)))
+			{
+				first->data = region[i].data;
+				BUCKET_METHODNAME(freekey)(&region[i], task->new_hm->alloc);
+				break;
+			}
+		}
+
+		if (seen[pos])
+			continue;
+
+		region[kept] = region[i];
+		seen[pos] = ++kept;
+	}
+
+	return (kept);
+}
+
+/*!
+ * @brief place the sorted Buckets of a run of regions in those regions.
+ *
+ * @param arg pointer to a `GrowTask`.
+ * @returns 0 always.
+ */
+static int HASHMAP_METHODNAME(grow_place_task)(void *const arg)
+{
+	struct GROW_TASK_STRUCT_TAG *const restrict task = arg;
+	len_ty left = 0;
+
+	task->kept = task->key_bytes = task->key_blocks = 0;
+	for (len_ty r = task->first; r < task->last; r++)
+	{
+		BUCKET_STRUCT_TAG *const restrict region =
+			&task->sorted[task->starts[r] - task->starts[task->first]];
+		len_ty count = task->starts[r + 1] - task->starts[r];
+
+		if (task->seen)
+			count = HASHMAP_METHODNAME(dedup_region)(task, region, count);
+
+		task->kept += count;
+		for (len_ty i = 0; i < count; i++)
+		{
+			BUCKET_STRUCT_TAG bucket = region[i];
+
+			BUCKET_METHODNAME(count_key)(
+				&bucket, &task->key_bytes, &task->key_blocks, 1
+			);
+			if (HASHMAP_METHODNAME(place_in_range)(
+					task->new_hm, &bucket, task->end
+				))
+				continue;
+
+			/* `place` counts the Bucket that did not fit. */
+			BUCKET_METHODNAME(count_key)(
+				&bucket, &task->key_bytes, &task->key_blocks, -1
+			);
+			task->sorted[left++] = bucket;
+		}
+	}
+
+	task->count = left;
+	return (0);
+}
+
+/*!
+ * @brief run `GrowTask`s on separate threads and wait for all of them.
+ *
+ * The calling thread runs the first task, and any task a thread could not be
+ * started for.
+ *
+ * @param tasks the tasks.
+ * @param count number of tasks.
+ * @param func function to run the tasks with.
+ */
+static void HASHMAP_METHODNAME(run_grow_tasks)(
+	struct GROW_TASK_STRUCT_TAG *const restrict tasks,
+	const unsigned int count, const thrd_start_t func
+)
+{
+	thrd_t threads[HASHMAP_MAX_GROW_THREADS];
+	bool started[HASHMAP_MAX_GROW_THREADS] = {0};
+
+	for (unsigned int t = 1; t < count; t++)
+		started[t] = thrd_create(&threads[t], func, &tasks[t]) == thrd_success;
+
+	func(&tasks[0]);
+	for (unsigned int t = 1; t < count; t++)
+	{
+		if (started[t])
+			thrd_join(threads[t], NULL);
+		else
+			func(&tasks[t]);
+	}
+}
+
+	#ifdef EMPTY_BUCKET_STACK
+/*!
+ * @brief link the unused slots of a `HashMap` into the empty Bucket stack
+ * again, after Buckets were placed without unlinking their slots.
+ *
+ * @param hm pointer to the HashMap.
+ */
+static void
+HASHMAP_METHODNAME(restack)(HASHMAP_STRUCT_TAG *const restrict hm)
+{
+	pos_ty top_pos = 0;
+
+	/* The last slots end up at the top, as in a new HashMap. */
+	for (len_ty i = 0; i < SLOT_COUNT(hm); i++)
+	{
+		if (BUCKET_METHODNAME(islive)(hm->arr[i]) == true)
+			continue;
+
+		const pos_ty pos = PTR_TO_POS(hm->arr, &hm->arr[i]);
+
+		hm->arr[i].next_pos = top_pos;
+		hm->arr[i].prev_pos = 0;
+		if (top_pos)
+			POS_TO_PTR(hm->arr, top_pos)->prev_pos = pos;
+
+		top_pos = pos;
+	}
+
+	hm->top_pos = top_pos;
+}
+	#endif /* EMPTY_BUCKET_STACK */
+
+/*!
+ * @brief number of slots of a `HashMap` in each region Buckets are sorted by.
+ *
+ * @param hm pointer to the HashMap.
+ * @returns the number of slots, whole cache lines and bitmap words so that
+ * the threads placing Buckets in different regions share neither.
+ */
+static len_ty
+HASHMAP_METHODNAME(region_size)(const HASHMAP_STRUCT_TAG *const restrict hm)
+{
+	const len_ty size =
+		(hm->capacity + HASHMAP_GROW_REGIONS - 1) / HASHMAP_GROW_REGIONS;
+
+	return ((size + 63) / 64 * 64);
+}
+
+/*!
+ * @brief sort Buckets by region with several threads, first counting them
+ * and then moving them.
+ *
+ * @param tasks the tasks, with their ranges and zeroed `offsets`.
+ * @param threads number of tasks.
+ * @param func function counting or moving the Buckets of a task.
+ * @param starts set to the index where each region starts, and after the
+ * last region the number of Buckets.
+ * @returns the sorted Buckets, NULL on failure or if a task failed while
+ * counting.
+ */
+static BUCKET_STRUCT_TAG *HASHMAP_METHODNAME(sort_by_region)(
+	struct GROW_TASK_STRUCT_TAG *const restrict tasks,
+	const unsigned int threads, const thrd_start_t func,
+	len_ty *const restrict starts
+)
+{
+	HASHMAP_METHODNAME(run_grow_tasks)(tasks, threads, func);
+	for (unsigned int t = 0; t < threads; t++)
+	{
+		if (tasks[t].failed)
+			return (NULL);
+	}
+
+	/* Within a region, the Buckets of a range of slots or keys follow */
+	/* those of the ranges before it. */
+	len_ty next = 0;
+
+	for (len_ty r = 0; r < HASHMAP_GROW_REGIONS; r++)
+	{
+		starts[r] = next;
+		for (unsigned int t = 0; t < threads; t++)
+		{
+			const len_ty region_count = tasks[t].offsets[r];
+
+			tasks[t].offsets[r] = next;
+			next += region_count;
+		}
+	}
+
+	starts[HASHMAP_GROW_REGIONS] = next;
+
+	BUCKET_STRUCT_TAG *const restrict sorted =
+		xmalloc(sizeof(*sorted) * (size_t)(next > 0 ? next : 1));
+
+	if (!sorted)
+		return (NULL);
+
+	for (unsigned int t = 0; t < threads; t++)
+		tasks[t].sorted = sorted;
+
+	HASHMAP_METHODNAME(run_grow_tasks)(tasks, threads, func);
+	return (sorted);
+}
+
+/*!
+ * @brief place sorted Buckets in a `HashMap` with several threads.
+ *
+ * Each thread places the Buckets of a run of regions in the slots of those
+ * regions, then the calling thread places those that did not fit.
+ *
+ * @param hm pointer to the HashMap, its slots should all be unused.
+ * @param tasks the tasks that sorted the Buckets.
+ * @param threads number of tasks.
+ * @param sorted the sorted Buckets.
+ * @param starts index in `sorted` where each region starts.
+ * @param dedup true to drop the Buckets whose keys come again later.
+ * @returns true on success, false if memory ran out, the Buckets are then
+ * untouched.
+ */
+static bool HASHMAP_METHODNAME(place_sorted)(
+	HASHMAP_STRUCT_TAG *const restrict hm,
+	struct GROW_TASK_STRUCT_TAG *const restrict tasks,
+	const unsigned int threads, BUCKET_STRUCT_TAG *const restrict sorted,
+	const len_ty *const restrict starts, const bool dedup
+)
+{
+	const len_ty region_size = tasks[0].region_size;
+	const len_ty regions = (hm->capacity + region_size - 1) / region_size;
+	size_t seen_size = 0;
+
+	for (unsigned int t = 0; t < threads; t++)
+	{
+		const len_ty first = regions * t / threads;
+		const len_ty last = regions * (t + 1) / threads;
+		const len_ty end = last * region_size;
+		len_ty largest = 0, size = 1;
+
+		tasks[t].begin = first * region_size;
+		tasks[t].end = end < hm->capacity ? end : hm->capacity;
+		tasks[t].sorted = &sorted[starts[first]];
+		tasks[t].starts = starts;
+		tasks[t].first = first;
+		tasks[t].last = last;
+		tasks[t].seen = NULL;
+		if (!dedup)
+			continue;
+
+		for (len_ty r = first; r < last; r++)
+		{
+			if (starts[r + 1] - starts[r] > largest)
+				largest = starts[r + 1] - starts[r];
+		}
+
+		while (size < largest * 2)
+			size *= 2;
+
+		tasks[t].seen_mask = size - 1;
+		seen_size += size;
+	}
+
+	len_ty *const restrict seen =
+		dedup ? xmalloc(sizeof(*seen) * seen_size) : NULL;
+
+	if (dedup && !seen)
+		return (false);
+
+	for (unsigned int t = 0; dedup && t < threads; t++)
+		tasks[t].seen = &seen[seen_size -= tasks[t].seen_mask + 1];
+
+	HASHMAP_METHODNAME(run_grow_tasks)(
+		tasks, threads, HASHMAP_METHODNAME(grow_place_task)
+	);
+
+	xfree(seen);
+	hm->used = 0;
+	for (unsigned int t = 0; t < threads; t++)
+	{
+		hm->used += tasks[t].kept - tasks[t].count;
+		hm->key_bytes += tasks[t].key_bytes;
+		hm->key_blocks += tasks[t].key_blocks;
+	}
+
+	#ifdef EMPTY_BUCKET_STACK
+	HASHMAP_METHODNAME(restack)(hm);
+	#endif /* EMPTY_BUCKET_STACK */
+	for (unsigned int t = 0; t < threads; t++)
+	{
+		for (len_ty i = 0; i < tasks[t].count; i++)
+		{
+			/* slots should not run out. */
+			HASHMAP_METHODNAME(place)(
+				hm, tasks[t].sorted[i],
+				HASHMAP_METHODNAME(find_slot)(hm, tasks[t].sorted[i].hash)
+			);
+		}
+	}
+
+	return (true);
+}
+
+/*!
+ * @brief grow the capacity of a `HashMap` to the given capacity, moving the
+ * Buckets with several threads.
+ *
+ * The new slots are split into contiguous runs, one per thread. Each thread
+ * places the Buckets whose home slots are in its run using only the slots
+ * of its run. The Buckets that do not fit, those that need a collision
+ * chain or probe past the end of the run, are then placed by the calling
+ * thread as `grow` would. The new HashMap finds the same keys and data as
+ * one grown by `grow`, though the Buckets may be in other slots.
+ *
+ * The Buckets are copied to a sorted array on the way, so a HashMap with
+ * `n` Buckets needs room for `n` more while growing.
+ *
+ * @param hm pointer to the HashMap.
+ * @param capacity the new capacity.
+ * @param threads maximum number of threads to use, small HashMaps use fewer.
+ * @returns pointer to the expanded HashMap, NULL on failure.
+ */
+HASHMAP_STRUCT_TAG *HASHMAP_METHODNAME(grow_parallel)(
+	HASHMAP_STRUCT_TAG *const restrict hm, const len_ty capacity,
+	unsigned int threads
+)
+{
+	if (!hm || capacity < 1 || threads < 1 ||
+		threads > HASHMAP_MAX_GROW_THREADS ||
+		HASHMAP_METHODNAME(isvalid)(hm) == false)
+		return (NULL);
+
+	if (capacity <= hm->capacity)
+		return (hm);
+
+	#ifdef INCREMENTAL_RESIZE
+	HASHMAP_METHODNAME(migrate)(hm, LEN_TY_max);
+	#endif /* INCREMENTAL_RESIZE */
+	if (SLOT_COUNT(hm) / HASHMAP_GROW_THREAD_SLOTS < threads)
+		threads = (unsigned int)(SLOT_COUNT(hm) / HASHMAP_GROW_THREAD_SLOTS);
+
+	if (threads < 2)
+		return (HASHMAP_METHODNAME(rehash)(hm, capacity));
+
+	HASHMAP_STRUCT_TAG *const restrict new_hm =
+		HASHMAP_METHODNAME(new_with_allocator)(capacity, hm->alloc);
+	/* Per thread counts of every region, then where each region starts. */
+	len_ty *const restrict offsets = xcalloc(
+		((size_t)threads + 1) * HASHMAP_GROW_REGIONS + 1, sizeof(*offsets)
+	);
+
+	if (!new_hm || !offsets)
+	{
+		xfree(offsets);
+		return (HASHMAP_METHODNAME(delete)(new_hm, NULL));
+	}
+
+	struct GROW_TASK_STRUCT_TAG tasks[HASHMAP_MAX_GROW_THREADS];
+	len_ty *const restrict starts = &offsets[threads * HASHMAP_GROW_REGIONS];
+	const len_ty slots = SLOT_COUNT(hm);
+
+	for (unsigned int t = 0; t < threads; t++)
+		tasks[t] = (struct GROW_TASK_STRUCT_TAG){
+			.hm = hm,
+			.new_hm = new_hm,
+			.region_size = HASHMAP_METHODNAME(region_size)(new_hm),
+			.begin = slots * t / threads,
+			.end = slots * (t + 1) / threads,
+			.offsets = &offsets[(size_t)t * HASHMAP_GROW_REGIONS],
+		};
+
+	BUCKET_STRUCT_TAG *const restrict sorted =
+		HASHMAP_METHODNAME(sort_by_region)(
+			tasks, threads, HASHMAP_METHODNAME(grow_sort_task), starts
+		);
+
+	if (!sorted)
+	{
+		xfree(offsets);
+		return (HASHMAP_METHODNAME(delete)(new_hm, NULL));
+	}
+
+	/* The old HashMap is empty now, its Buckets are all in `sorted`. */
+	/* The stored hashes stay valid with the same seed. */
+	new_hm->seed = hm->seed;
+	HASHMAP_METHODNAME(place_sorted)(
+		new_hm, tasks, threads, sorted, starts, false
+	);
+	xfree(sorted);
+	xfree(offsets);
+	HASHMAP_METHODNAME(delete)(hm, NULL);
+	return (new_hm);
+}
+/*!
+ * @brief make a `HashMap` holding the given keys and data, with several
+ * threads.
+ *
+ * The HashMap is sized for all the keys up front, so it never grows while
+ * they are added. The keys are hashed and sorted by the region of their home
+ * slots in parallel, then the regions are filled in parallel as in
+ * `grow_parallel`. A key that comes more than once gets the data of its last
+ * occurrence, as if the keys had been inserted in order.
+ *
+ * @param keys the keys.
+ * @param values the data of each key.
+ * @param n number of keys.
+ * @param threads maximum number of threads to use, few keys use fewer.
+ * @returns pointer to the new HashMap, NULL on failure or if a key is
+ * invalid.
+ */
+HASHMAP_STRUCT_TAG *HASHMAP_METHODNAME(from_pairs)(
+	const KEY_TY *const restrict keys,
+	HASHMAP_DATATYPE const *const restrict values, const len_ty n,
+	unsigned int threads
+)
+{
+	if (n < 0 || (n > 0 && (!keys || !values)) || threads < 1 ||
+		threads > HASHMAP_MAX_GROW_THREADS)
+		return (NULL);
+
+	HASHMAP_STRUCT_TAG *restrict hm =
+		HASHMAP_METHODNAME(new)((len_ty)(n / HASHMAP_MAX_LOAD_FACTOR) + 1);
+
+	if (!hm)
+		return (NULL);
+
+	if (n / HASHMAP_GROW_THREAD_SLOTS < threads)
+		threads = (unsigned int)(n / HASHMAP_GROW_THREAD_SLOTS);
+
+	if (threads < 2)
+	{
+		for (len_ty i = 0; i < n; i++)
+		{
+			if (!HASHMAP_METHODNAME(insert)(&hm, keys[i], values[i]))
+				return (HASHMAP_METHODNAME(delete)(hm, NULL));
+		}
+
+		return (hm);
+	}
+
+	/* Per thread counts of every region, then where each region starts. */
+	len_ty *const restrict offsets = xcalloc(
+		((size_t)threads + 1) * HASHMAP_GROW_REGIONS + 1, sizeof(*offsets)
+	);
+	hash_ty *const restrict hashes = xmalloc(sizeof(*hashes) * (size_t)n);
+
+	if (!offsets || !hashes)
+	{
+		xfree(hashes);
+		xfree(offsets);
+		return (HASHMAP_METHODNAME(delete)(hm, NULL));
+	}
+
+	struct GROW_TASK_STRUCT_TAG tasks[HASHMAP_MAX_GROW_THREADS];
+	len_ty *const restrict starts = &offsets[threads * HASHMAP_GROW_REGIONS];
+
+	for (unsigned int t = 0; t < threads; t++)
+		tasks[t] = (struct GROW_TASK_STRUCT_TAG){
+			.new_hm = hm,
+			.keys = keys,
+			.values = values,
+			.hashes = hashes,
+			.region_size = HASHMAP_METHODNAME(region_size)(hm),
+			.begin = n * t / threads,
+			.end = n * (t + 1) / threads,
+			.offsets = &offsets[(size_t)t * HASHMAP_GROW_REGIONS],
+		};
+
+	BUCKET_STRUCT_TAG *const restrict sorted =
+		HASHMAP_METHODNAME(sort_by_region)(
+			tasks, threads, HASHMAP_METHODNAME(pairs_sort_task), starts
+		);
+	bool failed = !sorted;
+
+	for (unsigned int t = 0; t < threads; t++)
+		failed |= tasks[t].failed;
+
+	if (!failed)
+		failed = !HASHMAP_METHODNAME(place_sorted)(
+			hm, tasks, threads, sorted, starts, true
+		);
+
+	if (failed)
+	{
+		for (len_ty i = 0; sorted && i < n; i++)
+		{
+			if (BUCKET_METHODNAME(islive)(sorted[i]))
+				BUCKET_METHODNAME(freekey)(&sorted[i], hm->alloc);
+		}
+
+		hm = HASHMAP_METHODNAME(delete)(hm, NULL);
+	}
+
+	xfree(sorted);
+	xfree(hashes);
+	xfree(offsets);
+	return (hm);
+}
+#endif /* HASHMAP_PARALLEL_GROW */
+
+/*!
+ * @brief move the Buckets of a `HashMap` into a new HashMap with a fresh
+ * seed.
+ *
+ * Keys that collide under one seed are unlikely to collide under another,
+ * so this breaks up chains built from keys chosen to collide.
+ *
+ * @param hm pointer to the HashMap, it is deleted on success.
+ * @returns pointer to the new HashMap, NULL on failure.
+ */
+static HASHMAP_STRUCT_TAG *
+HASHMAP_METHODNAME(reseed)(HASHMAP_STRUCT_TAG *const restrict hm)
+{
+#ifdef INCREMENTAL_RESIZE
+	HASHMAP_METHODNAME(migrate)(hm, LEN_TY_max);
+#endif /* INCREMENTAL_RESIZE */
+	HASHMAP_STRUCT_TAG *const restrict new_hm =
+		HASHMAP_METHODNAME(new_with_allocator)(hm->capacity, hm->alloc);
+
+	if (!new_hm)
+		return (NULL);
+
+	len_ty i = SLOT_COUNT(hm);
+
+	while (i > 0)
+	{
+		i--;
+		if (BUCKET_METHODNAME(islive)(hm->arr[i]) == false)
+			continue;
+
+		BUCKET_STRUCT_TAG bucket = hm->arr[i];
+
+		bucket.hash = HASHMAP_METHODNAME(hash_key)(
+			new_hm->seed, BUCKET_METHODNAME(getkey)(&bucket)
+		);
+#ifdef HASHMAP_INTERN
+		bucket.key->hash = bucket.hash;
+#endif /* HASHMAP_INTERN */
+		/* slots should not run out. */
+		HASHMAP_METHODNAME(place)(
+			new_hm, bucket, HASHMAP_METHODNAME(find_slot)(new_hm, bucket.hash)
+		);
+		hm->arr[i] = (BUCKET_STRUCT_TAG){0};
+	}
+
+	new_hm->reseeded = true;
+	HASHMAP_METHODNAME(delete)(hm, NULL);
+	return (new_hm);
+}
+
+/*!
+ * @brief reseed a `HashMap` if a search walked a long chain.
+ *
+ * Only the functions that hash the keys themselves call this, a hash given
+ * to a `*_hashed` function stays valid through the call.
+ *
+ * @param hm address of the pointer to the HashMap, left as is on failure.
+ */
+static void HASHMAP_METHODNAME(reseed_long_chain)(
+	HASHMAP_STRUCT_TAG *restrict *const hm
+)
+{
+	if (!(*hm)->long_chain || (*hm)->reseeded)
+		return;
+
+	HASHMAP_STRUCT_TAG *const reseeded = HASHMAP_METHODNAME(reseed)(*hm);
+
+	if (reseeded)
+		*hm = reseeded;
+}
+
+/*!
+ * @brief get the capacity a `HashMap` has to be resized to before a new key
+ * is added to it.
+ *
+ * @param hm pointer to the HashMap.
+ * @returns the new capacity, 0 if the HashMap has room for the key.
+ */
+static len_ty
+HASHMAP_METHODNAME(next_capacity)(const HASHMAP_STRUCT_TAG *const restrict hm)
+{
+#ifdef CELLAR_COALESCED_HASHING
+	if (hm->cellar.used < hm->cellar.capacity)
+		return (0);
+#endif /* CELLAR_COALESCED_HASHING */
+
+#ifdef SWISS_TABLE_PROBING
+	/* Deleted slots lengthen probes just like used ones. */
+	if (hm->used + hm->deleted <= HASHMAP_MAX_LOAD_FACTOR * hm->capacity)
+		return (0);
+
+	/* Mostly deleted slots, clear them without growing. */
+	if (hm->used <= HASHMAP_MAX_LOAD_FACTOR * hm->capacity / 2)
+		return (hm->capacity);
+#else
+	if (hm->used <= HASHMAP_MAX_LOAD_FACTOR * hm->capacity)
+		return (0);
+#endif /* SWISS_TABLE_PROBING */
+
+	return (hm->capacity * 2);
+}
+
+/*!
+ * @brief double the capacity of a `HashMap` if needed.
+ *
+ * @param hm pointer to the HashMap to grow.
+ * @returns pointer to the doubled HashMap, NULL on failure.
+ */
+static HASHMAP_STRUCT_TAG *
+HASHMAP_METHODNAME(double_capacity)(HASHMAP_STRUCT_TAG *const restrict hm)
+{
+	const len_ty capacity = HASHMAP_METHODNAME(next_capacity)(hm);
+
+	if (!capacity)
+		return (hm);
+
+	return (HASHMAP_METHODNAME(resize)(hm, capacity));
+}
+
+/*!
+ * @brief move the Buckets of a `HashMap` into a new HashMap.
+ *
+ * With INCREMENTAL_RESIZE the old HashMap is attached to the new one and
+ * emptied a few slots at a time by the following operations, otherwise
+ * this is the same as `rehash`.
+ *
+ * @param hm pointer to the HashMap.
+ * @param capacity capacity of the new HashMap.
+ * @returns pointer to the new HashMap, NULL on failure.
+ */
+static HASHMAP_STRUCT_TAG *HASHMAP_METHODNAME(resize)(
+	HASHMAP_STRUCT_TAG *const restrict hm, const len_ty capacity
+)
+{
+#ifdef INCREMENTAL_RESIZE
+	/* Finish the last resize before starting another. */
+	HASHMAP_METHODNAME(migrate)(hm, LEN_TY_max);
+
+	HASHMAP_STRUCT_TAG *const restrict new_hm =
+		HASHMAP_METHODNAME(new_with_allocator)(capacity, hm->alloc);
+
+	if (!new_hm)
+		return (NULL);
+
+	new_hm->seed = hm->seed;
+	new_hm->old = hm;
+	new_hm->old_pos = hm->capacity;
+	#ifdef CELLAR_COALESCED_HASHING
+	new_hm->old_pos += hm->cellar.capacity;
+	#endif /* CELLAR_COALESCED_HASHING */
+	return (new_hm);
+#else
+	return (HASHMAP_METHODNAME(rehash)(hm, capacity));
+#endif /* INCREMENTAL_RESIZE */
+}
+
+#ifdef INCREMENTAL_RESIZE
+/*!
+ * @brief move Buckets from the old HashMap of a resizing `HashMap`.
+ *
+ * The old HashMap is emptied from its last slot to its first and deleted
+ * once empty.
+ *
+ * @param hm pointer to the HashMap.
+ * @param slots maximum number of old slots to empty.
+ */
+static void HASHMAP_METHODNAME(migrate)(
+	HASHMAP_STRUCT_TAG *const restrict hm, len_ty slots
+)
+{
+	HASHMAP_STRUCT_TAG *const restrict old = hm->old;
+
+	if (!old)
+		return;
+
+	for (; slots > 0 && hm->old_pos > 0; slots--)
+	{
+		BUCKET_STRUCT_TAG *const restrict bkt = &old->arr[hm->old_pos - 1];
+
+		/* Evicting a Bucket may move a later one in its chain into the */
+		/* slot, slots already emptied are never in a chain. */
+		while (BUCKET_METHODNAME(islive)(*bkt) == true)
+		{
+			const BUCKET_STRUCT_TAG moved = *bkt;
+
+			BUCKET_METHODNAME(count_key)(
+				&moved, &old->key_bytes, &old->key_blocks, -1
+			);
+			HASHMAP_METHODNAME(evict)(old, bkt);
+			/* slots should not run out. */
+			HASHMAP_METHODNAME(place)(
+				hm, moved, HASHMAP_METHODNAME(find_slot)(hm, moved.hash)
+			);
+		}
+
+		hm->old_pos--;
+	}
+
+	if (hm->old_pos == 0)
+		hm->old = HASHMAP_METHODNAME(delete)(old, NULL);
+}
+#endif /* INCREMENTAL_RESIZE */
+
+#if defined SWISS_TABLE_PROBING
+/*!
+ * @brief set the control byte of a slot in a `HashMap`.
+ *
+ * The first `CTRL_GROUP_WIDTH - 1` control bytes are mirrored after the last
+ * one so that groups near the end of the table wrap around to the start.
+ *
+ * @param hm pointer to the HashMap.
+ * @param i index of the slot.
+ * @param tag the new control byte.
+ */
+static void HASHMAP_METHODNAME(set_ctrl)(
+	HASHMAP_STRUCT_TAG *const restrict hm, const len_ty i,
+	const unsigned char tag
+)
+{
+	unsigned char *const restrict ctrl = CTRL_BYTES(hm);
+
+	for (len_ty j = i; j < CTRL_BYTES_SIZE(hm->capacity); j += hm->capacity)
+		ctrl[j] = tag;
+}
+
+/*!
+ * @brief find the slot to place a new `Bucket` from.
+ *
+ * @param hm pointer to the HashMap.
+ * @param hash hash of the Bucket.
+ * @returns index of the first empty or deleted slot on the probe sequence,
+ * -1 if there are none.
+ */
+static len_ty HASHMAP_METHODNAME(find_slot)(
+	HASHMAP_STRUCT_TAG *const restrict hm, const hash_ty hash
+)
+{
+	const unsigned char *const restrict ctrl = CTRL_BYTES(hm);
+	len_ty pos = FOLD(hash, hm->capacity);
+
+	for (len_ty probed = 0; probed < hm->capacity; probed += CTRL_GROUP_WIDTH)
+	{
+		const ctrl_mask free_slots = ctrl_group_match_free(&ctrl[pos]);
+
+		if (free_slots)
+			return (
+				(pos + ctrl_mask_trailing_zeros(free_slots)) % hm->capacity
+			);
+
+		pos = (pos + CTRL_GROUP_WIDTH) % hm->capacity;
+	}
+
+	return (-1);
+}
+
+/*!
+ * @brief insert a `Bucket` into a `HashMap`.
+ *
+ * @param hm pointer to the HashMap.
+ * @param bucket the Bucket to insert.
+ * @param slot the empty or deleted slot from `find_slot` or `search_key`.
+ * @returns pointer to the inserted Bucket, NULL if there are no more slots.
+ */
+static BUCKET_STRUCT_TAG *HASHMAP_METHODNAME(place)(
+	HASHMAP_STRUCT_TAG *const restrict hm, BUCKET_STRUCT_TAG bucket,
+	const len_ty slot
+)
+{
+	if (slot < 0)
+		return (NULL);
+
+	if (CTRL_BYTES(hm)[slot] == CTRL_DELETED)
+		hm->deleted--;
+
+	HASHMAP_METHODNAME(set_ctrl)(hm, slot, HASH_TAG(bucket.hash));
+	hm->arr[slot] = bucket;
+	hm->used++;
+	BUCKET_METHODNAME(count_key)(&bucket, &hm->key_bytes, &hm->key_blocks, 1);
+	return (&hm->arr[slot]);
+}
+#elif defined ROBIN_HOOD_HASHING
+/*!
+ * @brief number of slots between a live `Bucket` and its home slot.
+ *
+ * @param hm pointer to the HashMap.
+ * @param i index of the Bucket.
+ * @returns the probe distance of the Bucket.
+ */
+static len_ty HASHMAP_METHODNAME(probe_distance)(
+	const HASHMAP_STRUCT_TAG *const restrict hm, const len_ty i
+)
+{
+	const len_ty distance = i - (len_ty)FOLD(hm->arr[i].hash, hm->capacity);
+
+	return (distance < 0 ? distance + hm->capacity : distance);
+}
+
+/*!
+ * @brief find the slot to place a new `Bucket` from.
+ *
+ * @param hm pointer to the HashMap.
+ * @param hash hash of the Bucket.
+ * @returns index of the home slot.
+ */
+static len_ty HASHMAP_METHODNAME(find_slot)(
+	HASHMAP_STRUCT_TAG *const restrict hm, const hash_ty hash
+)
+{
+	return (FOLD(hash, hm->capacity));
+}
+
+/*!
+ * @brief insert a `Bucket` into a `HashMap`.
+ *
+ * Along the probe sequence the Bucket takes the slot of the first Bucket
+ * that is closer to its home slot, that Bucket then continues the probe.
+ *
+ * @param hm pointer to the HashMap.
+ * @param bucket the Bucket to insert.
+ * @param slot slot on the probe sequence of the Bucket to start from, from
+ * `find_slot` or `search_key`.
+ * @returns pointer to the inserted Bucket, NULL if there are no more slots.
+ */
+static BUCKET_STRUCT_TAG *HASHMAP_METHODNAME(place)(
+	HASHMAP_STRUCT_TAG *const restrict hm, BUCKET_STRUCT_TAG bucket,
+	const len_ty slot
+)
+{
+	if (slot < 0 || hm->used >= hm->capacity)
+		return (NULL);
+
+	/* Counted before it can be swapped for a displaced Bucket. */
+	BUCKET_METHODNAME(count_key)(&bucket, &hm->key_bytes, &hm->key_blocks, 1);
+	BUCKET_STRUCT_TAG *restrict placed = NULL;
+	len_ty pos = slot;
+	len_ty distance = pos - (len_ty)FOLD(bucket.hash, hm->capacity);
+
+	if (distance < 0)
+		distance += hm->capacity;
+
+	for (;; distance++)
+	{
+		if (distance == HASHMAP_RESEED_CHAIN)
+			hm->long_chain = true;
+
+		if (BUCKET_METHODNAME(islive)(hm->arr[pos]) == false)
+		{
+			hm->arr[pos] = bucket;
+			hm->used++;
+			return (placed ? placed : &hm->arr[pos]);
+		}
+
+		const len_ty pos_distance = HASHMAP_METHODNAME(probe_distance)(hm, pos);
+
+		if (pos_distance < distance)
+		{
+			const BUCKET_STRUCT_TAG displaced = hm->arr[pos];
+
+			hm->arr[pos] = bucket;
+			bucket = displaced;
+			distance = pos_distance;
+			if (!placed)
+				placed = &hm->arr[pos];
+		}
+
+		pos = pos + 1 < hm->capacity ? pos + 1 : 0;
+	}
+}
+#else
+/*!
+ * @brief unlink a bucket node from a linked list.
+ *
+ * @param hm pointer to the HashMap the bucket is in.
+ * @param bkt pointer to the bucket.
+ */
+static void BUCKET_METHODNAME(unlink)(
+	HASHMAP_STRUCT_TAG *const restrict hm,
+	BUCKET_STRUCT_TAG *const restrict bkt
+)
+{
+#ifdef EMPTY_BUCKET_STACK
+	if (POS_TO_PTR(hm->arr, hm->top_pos) == bkt)
+		hm->top_pos = bkt->next_pos;
+
+#endif /* EMPTY_BUCKET_STACK */
+	const pos_ty next_pos = NEXT_POS(hm, bkt);
+	const pos_ty prev_pos = bkt->prev_pos;
+	if (next_pos)
+		POS_TO_PTR(hm->arr, next_pos)->prev_pos = prev_pos;
+
+	if (prev_pos)
+		NEXT_POS(hm, POS_TO_PTR(hm->arr, prev_pos)) = next_pos;
+
+	NEXT_POS(hm, bkt) = 0;
+	bkt->prev_pos = 0;
+}
+
+/*!
+ * @brief search a `HashMap` for an empty `Bucket`.
+ *
+ * The Cellar if available will be searched first.
+ *
+ * @param hm the HashMap to search.
+ * @returns pointer to an empty Bucket, NULL if none.
+ */
+static BUCKET_STRUCT_TAG *
+HASHMAP_METHODNAME(get_empty)(HASHMAP_STRUCT_TAG *const restrict hm)
+{
+	BUCKET_STRUCT_TAG *restrict empty_bucket = NULL;
+#ifdef EMPTY_BUCKET_STACK
+
+	if (hm->top_pos)
+	{
+		empty_bucket = POS_TO_PTR(hm->arr, hm->top_pos);
+		BUCKET_METHODNAME(unlink)(hm, empty_bucket);
+	}
+#else
+	len_ty first = 0;
+	len_ty last = hm->capacity;
+
+	#ifdef CELLAR_COALESCED_HASHING
+	/* Check the cellar first if it has unused slots. */
+	if (hm->cellar.used < hm->cellar.capacity)
+	{
+		first = hm->capacity;
+		last += hm->cellar.capacity;
+	}
+	else
+	#endif /* CELLAR_COALESCED_HASHING */
+		if (hm->used >= hm->capacity)
+			return (NULL);
+
+	const len_ty i =
+		bitmap_find_clear(OCCUPANCY(hm), first, last, &hm->free_hint);
+
+	if (i >= 0)
+		empty_bucket = &hm->arr[i];
+#endif /* EMPTY_BUCKET_STACK */
+
+	if (empty_bucket)
+	{
+		*empty_bucket = (BUCKET_STRUCT_TAG){0};
+#ifdef HOT_COLD_SPLIT
+		LINK(hm, empty_bucket) = (LINK_STRUCT_TAG){0};
+#endif /* HOT_COLD_SPLIT */
+	}
+
+	return (empty_bucket);
+}
+
+/*!
+ * @brief find the slot to place a new `Bucket` from.
+ *
+ * @param hm pointer to the HashMap.
+ * @param hash hash of the Bucket.
+ * @returns index of the home slot if it is unused, otherwise index of the
+ * last Bucket in its chain.
+ */
+static len_ty HASHMAP_METHODNAME(find_slot)(
+	HASHMAP_STRUCT_TAG *const restrict hm, const hash_ty hash
+)
+{
+	BUCKET_STRUCT_TAG *restrict walk = &hm->arr[FOLD(hash, hm->capacity)];
+
+	if (BUCKET_METHODNAME(islive)(*walk) == true)
+	{
+		while (NEXT_POS(hm, walk))
+			walk = POS_TO_PTR(hm->arr, NEXT_POS(hm, walk));
+	}
+
+	return (walk - hm->arr);
+}
+
+/*!
+ * @brief insert a `Bucket` into a `HashMap`.
+ *
+ * @param hm pointer to the HashMap.
+ * @param bucket the Bucket to insert.
+ * @param slot the home slot of the Bucket if it is unused, otherwise the
+ * last Bucket of the chain, from `find_slot` or `search_key`.
+ * @returns pointer to the inserted Bucket, NULL if there are no more slots.
+ */
+static BUCKET_STRUCT_TAG *HASHMAP_METHODNAME(place)(
+	HASHMAP_STRUCT_TAG *const restrict hm, BUCKET_STRUCT_TAG bucket,
+	const len_ty slot
+)
+{
+#ifndef HOT_COLD_SPLIT
+	bucket.next_pos = 0;
+#endif /* HOT_COLD_SPLIT */
+	bucket.prev_pos = 0;
+	if (BUCKET_METHODNAME(islive)(hm->arr[slot]) == false)
+	{
+#ifdef EMPTY_BUCKET_STACK
+		BUCKET_METHODNAME(unlink)(hm, &hm->arr[slot]);
+#endif /* EMPTY_BUCKET_STACK */
+		hm->arr[slot] = bucket;
+#ifdef HOT_COLD_SPLIT
+		LINKS(hm)[slot] = (LINK_STRUCT_TAG){.hash = bucket.hash};
+#endif /* HOT_COLD_SPLIT */
+#ifdef OCCUPANCY_BITMAP
+		bitmap_set(OCCUPANCY(hm), slot);
+#endif /* OCCUPANCY_BITMAP */
+		hm->used++;
+		BUCKET_METHODNAME(count_key)(
+			&bucket, &hm->key_bytes, &hm->key_blocks, 1
+		);
+		return (&hm->arr[slot]);
+	}
+
+	BUCKET_STRUCT_TAG *const restrict alt_bucket =
+		HASHMAP_METHODNAME(get_empty)(hm);
+	if (!alt_bucket)
+		return (NULL);
+
+	/* Insert the bucket at the end of the chain. */
+	NEXT_POS(hm, &hm->arr[slot]) = PTR_TO_POS(hm->arr, alt_bucket);
+	bucket.prev_pos = PTR_TO_POS(hm->arr, &hm->arr[slot]);
+	*alt_bucket = bucket;
+#ifdef HOT_COLD_SPLIT
+	LINK(hm, alt_bucket) = (LINK_STRUCT_TAG){.hash = bucket.hash};
+#endif /* HOT_COLD_SPLIT */
+#ifdef OCCUPANCY_BITMAP
+	bitmap_set(OCCUPANCY(hm), alt_bucket - hm->arr);
+#endif /* OCCUPANCY_BITMAP */
+#ifdef CELLAR_COALESCED_HASHING
+	if (hm->cellar.capacity > 0 && alt_bucket >= &hm->arr[hm->capacity])
+		hm->cellar.used++;
+	else
+#endif /* CELLAR_COALESCED_HASHING */
+		hm->used++;
+
+	BUCKET_METHODNAME(count_key)(&bucket, &hm->key_bytes, &hm->key_blocks, 1);
+	return (alt_bucket);
+}
+#endif /* defined SWISS_TABLE_PROBING */
+
+/*!
+ * @brief insert a key data pair into a HashMap.
+ *
+ * The capacity of the HashMap will be doubled if the load factor is high,
+ * and it is rehashed with a fresh seed the first time at each capacity that
+ * a search walks more than `HASHMAP_RESEED_CHAIN` Buckets.
+ *
+ * @param hm address of the pointer to the HashMap to modify.
+ * @param key the key to insert.
+ * @param data the data to insert.
+ * @returns pointer to the data inserted, NULL on failure.
+ */
+HASHMAP_DATATYPE *HASHMAP_METHODNAME(insert)(
+	HASHMAP_STRUCT_TAG *restrict *const hm, const KEY_TY key,
+	HASHMAP_DATATYPE data
+)
+{
+	if (!hm || !*hm || HASHMAP_METHODNAME(isvalid)(*hm) == false)
+		return (NULL);
+
+	hash_ty hash;
+
+	HASHMAP_METHODNAME(reseed_long_chain)(hm);
+	if (!HASHMAP_METHODNAME(hash)(*hm, &hash, key))
+		return (NULL);
+
+	return (HASHMAP_METHODNAME(insert_hashed)(hm, hash, key, data));
+}
+
+/*!
+ * @brief insert a key data pair into a HashMap.
+ *
+ * The capacity of the HashMap will be doubled if the load factor is high.
+ * The seed is never changed here so that `hash` stays valid, a long chain
+ * only marks the HashMap to be reseeded by the next `insert`.
+ *
+ * @param hm address of the pointer to the HashMap to modify.
+ * @param hash hash of the key, as returned by `hash` for this HashMap under
+ * its current `seed`. A hash from another HashMap is only valid if both
+ * have the same seed, see `new_seeded`.
+ * @param key the key to insert.
+ * @param data the data to insert.
+ * @returns pointer to the data inserted, NULL on failure.
+ */
+HASHMAP_DATATYPE *HASHMAP_METHODNAME(insert_hashed)(
+	HASHMAP_STRUCT_TAG *restrict *const hm, const hash_ty hash,
+	const KEY_TY key, HASHMAP_DATATYPE data
+)
+{
+	if (!hm || !*hm || HASHMAP_METHODNAME(isvalid)(*hm) == false ||
+		!KEY_ISVALID(key))
+		return (NULL);
+
+	BUCKET_STRUCT_TAG *const restrict bucket =
+		HASHMAP_METHODNAME(put)(hm, hash, key, data, true);
+
+	if (!bucket)
+		return (NULL);
+
+	return (&bucket->data);
+}
+
+/*!
+ * @brief find the `Bucket` of a key, inserting the key if it is new.
+ *
+ * The key is searched for once, a new key is placed in the slot the search
+ * ended at unless the capacity had to be doubled.
+ *
+ * @param hm address of the pointer to the HashMap to modify.
+ * @param hash hash of the key under the current `seed` of the HashMap.
+ * @param key the key to find or insert.
+ * @param data the data of a new key.
+ * @param overwrite whether the data of an existing key is replaced by `data`.
+ * @returns pointer to the Bucket of the key, NULL on failure.
+ */
+static BUCKET_STRUCT_TAG *HASHMAP_METHODNAME(put)(
+	HASHMAP_STRUCT_TAG *restrict *const hm, const hash_ty hash,
+	const KEY_TY key, HASHMAP_DATATYPE data, const bool overwrite
+)
+{
+	HASHMAP_STRUCT_TAG *map = *hm;
+	len_ty slot;
+
+#ifdef INCREMENTAL_RESIZE
+	HASHMAP_METHODNAME(migrate)(map, HASHMAP_MIGRATE_STEP);
+#endif /* INCREMENTAL_RESIZE */
+	BUCKET_STRUCT_TAG *restrict bucket =
+		HASHMAP_METHODNAME(search_key)(map, hash, key, &slot);
+
+#ifdef INCREMENTAL_RESIZE
+	if (!bucket && map->old)
+		bucket = HASHMAP_METHODNAME(search_key)(map->old, hash, key, NULL);
+
+#endif /* INCREMENTAL_RESIZE */
+	if (bucket)
+	{
+		if (overwrite)
+			bucket->data = data;
+
+		return (bucket);
+	}
+
+	BUCKET_STRUCT_TAG new_bucket = {.data = data, .hash = hash};
+
+	if (!BUCKET_METHODNAME(setkey)(&new_bucket, key, map->alloc))
+		return (NULL);
+
+	HASHMAP_STRUCT_TAG *const grown = HASHMAP_METHODNAME(double_capacity)(map);
+
+	if (!grown)
+	{
+		BUCKET_METHODNAME(freekey)(&new_bucket, map->alloc);
+		return (NULL);
+	}
+
+	/* The slot from the search is only valid if the Buckets did not move. */
+	if (grown != map)
+	{
+		map = grown;
+		slot = HASHMAP_METHODNAME(find_slot)(map, hash);
+	}
+
+	*hm = map;
+	bucket = HASHMAP_METHODNAME(place)(map, new_bucket, slot);
+	if (!bucket)
+		BUCKET_METHODNAME(freekey)(&new_bucket, map->alloc);
+
+	return (bucket);
+}
+
+/*!
+ * @brief insert several key data pairs into a HashMap.
+ *
+ * Room for every key to be new is made before the first one is inserted, so
+ * the capacity is not doubled part way through. The keys are then handled
+ * `HASHMAP_BATCH_GROUP` at a time as in `search_batch`, and each key is
+ * placed in the slot its search ended at. A key that comes more than once
+ * gets the data of its last occurrence.
+ *
+ * @param hm address of the pointer to the HashMap to modify.
+ * @param keys array of the keys to insert.
+ * @param values array of the data of each key.
+ * @param n number of keys.
+ * @param added array of `n` flags, may be NULL. Set to true for each key
+ * that was new and to false for each key whose data was overwritten.
+ * @returns number of keys inserted. The keys after an invalid key or one
+ * that could not be inserted are left out.
+ */
+len_ty HASHMAP_METHODNAME(insert_batch)(
+	HASHMAP_STRUCT_TAG *restrict *const hm, const KEY_TY *const restrict keys,
+	HASHMAP_DATATYPE const *const restrict values, const len_ty n,
+	bool *const restrict added
+)
+{
+	if (!hm || !*hm || HASHMAP_METHODNAME(isvalid)(*hm) == false || n < 1 ||
+		!keys || !values)
+		return (0);
+
+	HASHMAP_METHODNAME(reseed_long_chain)(hm);
+	HASHMAP_STRUCT_TAG *map = *hm;
+	/* Buckets in the cellar or still in the old HashMap need room too. */
+	const len_ty held = HASHMAP_METHODNAME(count)(map);
+
+#ifdef SWISS_TABLE_PROBING
+	const len_ty taken = held + map->deleted;
+#else
+	const len_ty taken = held;
+#endif /* SWISS_TABLE_PROBING */
+
+	if (taken + n > HASHMAP_MAX_LOAD_FACTOR * map->capacity)
+	{
+		len_ty capacity = (len_ty)((held + n) / HASHMAP_MAX_LOAD_FACTOR) + 1;
+
+		/* At least double, or small batches would each rehash the map. */
+		if (capacity > map->capacity && capacity < map->capacity * 2)
+			capacity = map->capacity * 2;
+		else if (capacity < map->capacity)
+			capacity = map->capacity;
+
+		HASHMAP_STRUCT_TAG *const grown =
+			HASHMAP_METHODNAME(rehash)(map, capacity);
+
+		if (!grown)
+		{
+			*hm = map;
+			return (0);
+		}
+
+		map = grown;
+	}
+
+	*hm = map;
+
+	hash_ty hashes[HASHMAP_BATCH_GROUP];
+	bool hashed[HASHMAP_BATCH_GROUP];
+
+	for (len_ty start = 0; start < n; start += HASHMAP_BATCH_GROUP)
+	{
+		const len_ty group =
+			n - start < HASHMAP_BATCH_GROUP ? n - start : HASHMAP_BATCH_GROUP;
+
+#ifdef INCREMENTAL_RESIZE
+		HASHMAP_METHODNAME(migrate)(map, HASHMAP_MIGRATE_STEP);
+#endif /* INCREMENTAL_RESIZE */
+		for (len_ty i = 0; i < group; i++)
+		{
+			/* The HashMap was checked once for the whole batch. */
+			hashed[i] = KEY_ISVALID(keys[start + i]);
+			if (!hashed[i])
+				continue;
+
+			hashes[i] =
+				HASHMAP_METHODNAME(hash_key)(map->seed, keys[start + i]);
+
+			const len_ty home = FOLD(hashes[i], map->capacity);
+
+#if defined SWISS_TABLE_PROBING
+			PREFETCH(&CTRL_BYTES(map)[home]);
+#elif defined HOT_COLD_SPLIT
+			PREFETCH(&LINKS(map)[home]);
+#endif /* defined SWISS_TABLE_PROBING */
+#ifndef HOT_COLD_SPLIT
+			PREFETCH(&map->arr[home]);
+#endif /* HOT_COLD_SPLIT */
+		}
+
+		for (len_ty i = 0; i < group; i++)
+		{
+			const len_ty k = start + i;
+
+			if (!hashed[i])
+				return (k);
+
+			len_ty slot;
+			BUCKET_STRUCT_TAG *restrict bucket =
+				HASHMAP_METHODNAME(search_key)(map, hashes[i], keys[k], &slot);
+
+#ifdef INCREMENTAL_RESIZE
+			if (!bucket && map->old)
+				bucket = HASHMAP_METHODNAME(search_key)(
+					map->old, hashes[i], keys[k], NULL
+				);
+
+#endif /* INCREMENTAL_RESIZE */
+			if (bucket)
+			{
+				bucket->data = values[k];
+				if (added)
+					added[k] = false;
+
+				continue;
+			}
+
+			BUCKET_STRUCT_TAG new_bucket = {
+				.data = values[k], .hash = hashes[i]
+			};
+
+			if (!BUCKET_METHODNAME(setkey)(&new_bucket, keys[k], map->alloc))
+				return (k);
+
+			if (!HASHMAP_METHODNAME(place)(map, new_bucket, slot))
+			{
+				BUCKET_METHODNAME(freekey)(&new_bucket, map->alloc);
+				return (k);
+			}
+
+			if (added)
+				added[k] = true;
+		}
+	}
+
+	return (n);
+}
+
+#ifdef HASHMAP_INTERN
+/*!
+ * @brief get the canonical handle of a key, inserting the key if needed.
+ *
+ * Keys inserted by this function have zeroed data. The handle stays valid
+ * until its key is removed or the HashMap is deleted, resizing and
+ * reseeding do not move it.
+ *
+ * @param hm address of the pointer to the HashMap to intern the key in.
+ * @param key the key to intern.
+ * @returns the handle of the key, NULL on failure.
+ */
+const INTERNED_STRUCT_TAG *HASHMAP_METHODNAME(intern)(
+	HASHMAP_STRUCT_TAG *restrict *const hm, const u8mem key
+)
+{
+	if (!hm || !*hm || HASHMAP_METHODNAME(isvalid)(*hm) == false)
+		return (NULL);
+
+	hash_ty hash;
+
+	HASHMAP_METHODNAME(reseed_long_chain)(hm);
+	if (!HASHMAP_METHODNAME(hash)(*hm, &hash, key))
+		return (NULL);
+
+	/* An interned key keeps its data, only a new key gets zeroed data. */
+	const BUCKET_STRUCT_TAG *const restrict bucket =
+		HASHMAP_METHODNAME(put)(hm, hash, key, (HASHMAP_DATATYPE){0}, false);
+
+	if (!bucket)
+		return (NULL);
+
+	return (bucket->key);
+}
+
+#endif /* HASHMAP_INTERN */
+/*!
+ * @brief take a live `Bucket` out of a `HashMap`.
+ *
+ * @param hm pointer to the HashMap the Bucket is in.
+ * @param hole pointer to the Bucket, its key should already be freed or
+ * owned elsewhere.
+ */
+static void HASHMAP_METHODNAME(evict)(
+	HASHMAP_STRUCT_TAG *const restrict hm, BUCKET_STRUCT_TAG *restrict hole
+)
+{
+#if defined SWISS_TABLE_PROBING
+	const unsigned char *const restrict ctrl = CTRL_BYTES(hm);
+	const len_ty i = hole - hm->arr;
+	const ctrl_mask empty_after = ctrl_group_match_empty(&ctrl[i]);
+	const ctrl_mask empty_before = ctrl_group_match_empty(&ctrl[(
+		i + hm->capacity - CTRL_GROUP_WIDTH % hm->capacity
+	) % hm->capacity]);
+	/* Probes only go past groups without empty slots, if every group */
+	/* holding this slot has one then no probe went past this slot. */
+	const bool was_never_full =
+		empty_before && empty_after &&
+		ctrl_mask_trailing_zeros(empty_after) +
+				ctrl_mask_leading_zeros(empty_before) <
+			CTRL_GROUP_WIDTH;
+
+	*hole = (BUCKET_STRUCT_TAG){0};
+	HASHMAP_METHODNAME(set_ctrl)(
+		hm, i, was_never_full ? CTRL_EMPTY : CTRL_DELETED
+	);
+	if (!was_never_full)
+		hm->deleted++;
+
+	hm->used--;
+#elif defined ROBIN_HOOD_HASHING
+	const len_ty start = hole - hm->arr;
+	len_ty i = start;
+	len_ty next = i + 1 < hm->capacity ? i + 1 : 0;
+
+	/* Shift the following Buckets back by one until a Bucket is at its */
+	/* home slot. */
+	while (next != start && BUCKET_METHODNAME(islive)(hm->arr[next]) == true &&
+		   HASHMAP_METHODNAME(probe_distance)(hm, next) > 0)
+	{
+		hm->arr[i] = hm->arr[next];
+		i = next;
+		next = i + 1 < hm->capacity ? i + 1 : 0;
+	}
+
+	hm->arr[i] = (BUCKET_STRUCT_TAG){0};
+	hm->used--;
+#else
+	/* Buckets whose home is the hole are always further down the chain, */
+	/* fill the hole with the first of them and repeat with its slot. */
+	for (BUCKET_STRUCT_TAG *restrict walk =
+			 POS_TO_PTR(hm->arr, NEXT_POS(hm, hole));
+		 walk; walk = POS_TO_PTR(hm->arr, NEXT_POS(hm, walk)))
+	{
+		if (&hm->arr[FOLD(HASH_OF(hm, walk), hm->capacity)] != hole)
+			continue;
+
+		const pos_ty prev_pos = hole->prev_pos;
+
+	#ifdef HOT_COLD_SPLIT
+		HASH_OF(hm, hole) = HASH_OF(hm, walk);
+		*hole = *walk;
+	#else
+		const pos_ty next_pos = hole->next_pos;
+
+		*hole = *walk;
+		hole->next_pos = next_pos;
+	#endif /* HOT_COLD_SPLIT */
+		hole->prev_pos = prev_pos;
+		hole = walk;
+	}
+
+	BUCKET_METHODNAME(unlink)(hm, hole);
+	*hole = (BUCKET_STRUCT_TAG){0};
+	#ifdef HOT_COLD_SPLIT
+	HASH_OF(hm, hole) = 0;
+	#endif /* HOT_COLD_SPLIT */
+	#ifdef OCCUPANCY_BITMAP
+	bitmap_clear(OCCUPANCY(hm), hole - hm->arr);
+	#endif /* OCCUPANCY_BITMAP */
+	#ifdef EMPTY_BUCKET_STACK
+	hole->next_pos = hm->top_pos;
+	if (hm->top_pos)
+		POS_TO_PTR(hm->arr, hm->top_pos)->prev_pos =
+			PTR_TO_POS(hm->arr, hole);
+
+	hm->top_pos = PTR_TO_POS(hm->arr, hole);
+	#endif /* EMPTY_BUCKET_STACK */
+	#ifdef CELLAR_COALESCED_HASHING
+	if (hm->cellar.capacity > 0 && hole >= &hm->arr[hm->capacity])
+		hm->cellar.used--;
+	else
+	#endif /* CELLAR_COALESCED_HASHING */
+		hm->used--;
+#endif /* defined SWISS_TABLE_PROBING */
+}
+
+/*!
+ * @brief remove the `Bucket` containing the given key.
+ *
+ * @param hm pointer to the HashMap to edit.
+ * @param dest address to store the data in the Bucket.
+ * @param key the key of the bucket to remove.
+ * @returns true on success, false on failure.
+ */
+bool HASHMAP_METHODNAME(remove)(
+	HASHMAP_STRUCT_TAG *restrict hm, HASHMAP_DATATYPE *const restrict dest,
+	const KEY_TY key
+)
+{
+	if (!hm || HASHMAP_METHODNAME(isvalid)(hm) == false)
+		return (false);
+
+	hash_ty hash;
+
+	if (!HASHMAP_METHODNAME(hash)(hm, &hash, key))
+		return (false);
+
+	return (HASHMAP_METHODNAME(remove_hashed)(hm, dest, hash, key));
+}
+
+/*!
+ * @brief remove the `Bucket` containing the given key.
+ *
+ * @param hm pointer to the HashMap to edit.
+ * @param dest address to store the data in the Bucket.
+ * @param hash hash of the key, as returned by `hash` for this HashMap under
+ * its current `seed`. A hash from another HashMap is only valid if both
+ * have the same seed, see `new_seeded`.
+ * @param key the key of the bucket to remove.
+ * @returns true on success, false on failure.
+ */
+bool HASHMAP_METHODNAME(remove_hashed)(
+	HASHMAP_STRUCT_TAG *restrict hm, HASHMAP_DATATYPE *const restrict dest,
+	const hash_ty hash, const KEY_TY key
+)
+{
+	if (!hm || HASHMAP_METHODNAME(isvalid)(hm) == false || !KEY_ISVALID(key))
+		return (false);
+
+#ifdef INCREMENTAL_RESIZE
+	HASHMAP_METHODNAME(migrate)(hm, HASHMAP_MIGRATE_STEP);
+#endif /* INCREMENTAL_RESIZE */
+	BUCKET_STRUCT_TAG *restrict hole =
+		HASHMAP_METHODNAME(search_key)(hm, hash, key, NULL);
+
+#ifdef INCREMENTAL_RESIZE
+	if (!hole && hm->old)
+	{
+		hm = hm->old;
+		hole = HASHMAP_METHODNAME(search_key)(hm, hash, key, NULL);
+	}
+
+#endif /* INCREMENTAL_RESIZE */
+	if (!hole)
+		return (false);
+
+	if (dest)
+		*dest = hole->data;
+
+	BUCKET_METHODNAME(count_key)(hole, &hm->key_bytes, &hm->key_blocks, -1);
+	BUCKET_METHODNAME(freekey)(hole, hm->alloc);
+	HASHMAP_METHODNAME(evict)(hm, hole);
+
+	return (true);
+}
+
+#ifdef HASHMAP_KEYTYPE
+/*!
+ * @brief return the bytes of a key in hexadecimal, highest address first.
+ *
+ * @param key the key to stringify.
+ * @returns pointer to the string, NULL on failure.
+ */
+static char *HASHMAP_METHODNAME(key_tostr)(const KEY_TY key)
+{
+	const unsigned char *const restrict bytes = (const unsigned char *)&key;
+	char *const restrict s = xmalloc(sizeof(key) * 2 + 3);
+
+	if (!s)
+		return (NULL);
+
+	s[0] = '0';
+	s[1] = 'x';
+	for (size_t i = 0; i < sizeof(key); ++i)
+		sprintf(&s[2 + i * 2], "%02x", bytes[sizeof(key) - 1 - i]);
+
+	return (s);
+}
+
+#endif /* HASHMAP_KEYTYPE */
+/*!
+ * @brief write the string representation of a `Bucket` into a buffer.
+ *
+ * @param bucket the Bucket.
+ * @param buf the char buffer.
+ * @param i cursor into the buffer.
+ * @param data_tostr pointer to a function that can stringify the data in
+ * the Bucket.
+ * @returns pointer to the buffer, NULL on error.
+ */
+static char *BUCKET_METHODNAME(tostr)(
+	const BUCKET_STRUCT_TAG bucket,
+	HM_CONCAT(stringify_data_, HASHMAP_UNIQUE_SUFFIX) * data_tostr
+)
+{
+#ifdef HASHMAP_KEYTYPE
+	char *const restrict key_str =
+		HASHMAP_METHODNAME(key_tostr)(BUCKET_METHODNAME(getkey)(&bucket));
+#else
+	char *const restrict key_str =
+		u8mem_tostr(BUCKET_METHODNAME(getkey)(&bucket));
+#endif /* HASHMAP_KEYTYPE */
+	char *const restrict data_str = data_tostr(bucket.data);
+	char *restrict bucket_str = NULL;
+
+	if (!key_str || !data_str)
+		goto cleanup;
+
+	const long int len = snprintf(NULL, 0, "%s: %s", key_str, data_str) + 1;
+
+	if (len < 1)
+		goto cleanup;
+
+	bucket_str = xmalloc(len);
+	if (!bucket_str)
+		goto cleanup;
+
+	if (snprintf(bucket_str, len, "%s: %s", key_str, data_str) < 0)
+		bucket_str = xfree(bucket_str);
+
+cleanup:
+	xfree(key_str);
+	xfree(data_str);
+	return (bucket_str);
+}
+
+/*!
+ * @brief return the string representation of a `HashMap`.
+ *
+ * @param hm the HashMap to stringify.
+ * @param data_tostr pointer to a function that can stringify the data in
+ * the Buckets.
+ * @returns pointer to the stringified data, NULL on failure.
+ */
+char *HASHMAP_METHODNAME(tostr)(
+	const HASHMAP_STRUCT_TAG *const restrict hm,
+	HM_CONCAT(stringify_data_, HASHMAP_UNIQUE_SUFFIX) * data_tostr
+)
+{
+	if (HASHMAP_METHODNAME(isvalid)(hm) == false || !data_tostr)
+		return (NULL);
+
+	char *restrict hm_str = xcalloc(3, sizeof(*hm_str));
+
+	if (!hm_str)
+		return (NULL);
+
+	/* Buckets still in the old HashMap of a resize are included. */
+	const HASHMAP_STRUCT_TAG *const tables[] = {
+		hm,
+#ifdef INCREMENTAL_RESIZE
+		hm->old,
+#endif /* INCREMENTAL_RESIZE */
+	};
+	size_t s_len = 1;
+
+	hm_str[0] = '{';
+	for (size_t t = 0; t < sizeof(tables) / sizeof(*tables) && tables[t]; t++)
+	{
+		const HASHMAP_STRUCT_TAG *const restrict map = tables[t];
+#ifdef CELLAR_COALESCED_HASHING
+		const len_ty end = map->capacity + map->cellar.capacity;
+#else
+		const len_ty end = map->capacity;
+#endif /* CELLAR_COALESCED_HASHING */
+
+		for (len_ty i = 0; hm_str && i < end; i++)
+		{
+			if (BUCKET_METHODNAME(islive)(map->arr[i]) == false)
+				continue;
+
+			char *const restrict bucket_str =
+				BUCKET_METHODNAME(tostr)(map->arr[i], data_tostr);
+
+			if (!bucket_str)
+				return (xfree(hm_str));
+
+			const char *const restrict sep = s_len > 1 ? ", " : "";
+			const size_t b_len = strlen(sep) + strlen(bucket_str);
+
+			/* Space for the closing brace and null byte is kept. */
+			hm_str = xrealloc_free_on_fail(hm_str, s_len + b_len + 2);
+			if (hm_str)
+			{
+				sprintf(hm_str + s_len, "%s%s", sep, bucket_str);
+				s_len += b_len;
+			}
+
+			xfree(bucket_str);
+		}
+	}
+
+	if (hm_str)
+	{
+		hm_str[s_len] = '}';
+		hm_str[s_len + 1] = '\0';
+	}
+
+	return (hm_str);
+}
+
+/*!
+ * @brief count the keys in a `HashMap`, including those not yet migrated.
+ *
+ * @param hm the HashMap, may be NULL.
+ * @returns the number of keys.
+ */
+static len_ty HASHMAP_METHODNAME(count)(const HASHMAP_STRUCT_TAG *const hm)
+{
+	if (!hm)
+		return (0);
+
+	len_ty used = hm->used;
+
+#ifdef CELLAR_COALESCED_HASHING
+	used += hm->cellar.used;
+#endif /* CELLAR_COALESCED_HASHING */
+#ifdef INCREMENTAL_RESIZE
+	used += HASHMAP_METHODNAME(count)(hm->old);
+#endif /* INCREMENTAL_RESIZE */
+	return (used);
+}
+
+/*!
+ * @brief report the memory used by a `HashMap`.
+ *
+ * The sizes of the blocks allocated for keys are known exactly, the
+ * bookkeeping of the allocator is estimated as `HASHMAP_ALLOC_OVERHEAD`
+ * bytes per block. The old HashMap of a resize is included.
+ *
+ * @param hm the HashMap.
+ * @param dest address to store the report in.
+ * @returns true on success, false on failure.
+ */
+bool HASHMAP_METHODNAME(memory_usage)(
+	const HASHMAP_STRUCT_TAG *const restrict hm, hm_memory *const restrict dest
+)
+{
+	if (!hm || HASHMAP_METHODNAME(isvalid)(hm) == false || !dest)
+		return (false);
+
+	*dest = (hm_memory){0};
+	for (const HASHMAP_STRUCT_TAG *map = hm; map;)
+	{
+#ifdef CELLAR_COALESCED_HASHING
+		const len_ty cellar_capacity = map->cellar.capacity;
+#else
+		const len_ty cellar_capacity = 0;
+#endif /* CELLAR_COALESCED_HASHING */
+
+		dest->table += sizeof(*map) + sizeof(*map->arr) * map->capacity +
+					   HASHMAP_METHODNAME(side_size)(
+						   map->capacity, cellar_capacity
+					   );
+		dest->cellar += sizeof(*map->arr) * cellar_capacity;
+		dest->keys += map->key_bytes;
+		dest->overhead +=
+			HASHMAP_ALLOC_OVERHEAD * (1 + (size_t)map->key_blocks);
+#ifdef INCREMENTAL_RESIZE
+		map = map->old;
+#else
+		map = NULL;
+#endif /* INCREMENTAL_RESIZE */
+	}
+
+	dest->total = dest->table + dest->cellar + dest->keys + dest->overhead;
+
+	const len_ty keys = HASHMAP_METHODNAME(count)(hm);
+
+	dest->per_key = keys ? (double)dest->total / keys : 0;
+	return (true);
+}
+
+#if defined HASHMAP_CONCURRENT || defined HASHMAP_SHARDED
+/* Locked HashMaps. */
+
+/*!
+ * @brief allocate the HashMap of a `Stripe` and initialise its lock.
+ *
+ * @param stripe the stripe to initialise.
+ * @param capacity number of Buckets in the HashMap.
+ * @returns true on success, false on failure.
+ */
+static bool HASHMAP_METHODNAME(stripe_init)(
+	STRIPE_STRUCT_TAG *const restrict stripe, const len_ty capacity
+)
+{
+	stripe->map = HASHMAP_METHODNAME(new)(capacity);
+	if (!stripe->map)
+		return (false);
+
+	if (mtx_init(&stripe->lock, mtx_plain) != thrd_success)
+	{
+		stripe->map = HASHMAP_METHODNAME(delete)(stripe->map, NULL);
+		return (false);
+	}
+
+	return (true);
+}
+
+/*!
+ * @brief free an array of initialised `Stripe`s.
+ *
+ * @param stripes the stripes, may be NULL.
+ * @param count number of stripes that were initialised.
+ * @param data_free function that will be used to free the data.
+ */
+static void HASHMAP_METHODNAME(stripes_delete)(
+	STRIPE_STRUCT_TAG *const restrict stripes, const len_ty count,
+	HM_CONCAT(free_mem_, HASHMAP_UNIQUE_SUFFIX) * data_free
+)
+{
+	for (len_ty i = 0; i < count; i++)
+	{
+		HASHMAP_METHODNAME(delete)(stripes[i].map, data_free);
+		mtx_destroy(&stripes[i].lock);
+	}
+
+	free(stripes);
+}
+
+/*!
+ * @brief insert a key data pair into the HashMap of a locked `Stripe`.
+ *
+ * @param stripe the stripe, its lock must be held.
+ * @param seed the seed `hash` was computed with.
+ * @param hash hash of the key.
+ * @param key the key to insert.
+ * @param data the data to insert.
+ * @returns true on success, false on failure.
+ */
+static bool HASHMAP_METHODNAME(stripe_insert)(
+	STRIPE_STRUCT_TAG *const restrict stripe, const uint64_t seed,
+	const hash_ty hash, const KEY_TY key, HASHMAP_DATATYPE data
+)
+{
+	HASHMAP_METHODNAME(reseed_long_chain)(&stripe->map);
+
+	/* A HashMap with another seed has to hash the key itself. */
+	const HASHMAP_DATATYPE *const restrict inserted =
+		stripe->map->seed == seed
+			? HASHMAP_METHODNAME(insert_hashed)(&stripe->map, hash, key, data)
+			: HASHMAP_METHODNAME(insert)(&stripe->map, key, data);
+
+	return (inserted != NULL);
+}
+
+/*!
+ * @brief search the HashMap of a locked `Stripe` for the data of a key.
+ *
+ * @param stripe the stripe, its lock must be held.
+ * @param seed the seed `hash` was computed with.
+ * @param hash hash of the key.
+ * @param dest address to copy the data of the key to, can be NULL.
+ * @param key the key to search for.
+ * @returns true if the key was found, false otherwise.
+ */
+static bool HASHMAP_METHODNAME(stripe_search)(
+	STRIPE_STRUCT_TAG *const restrict stripe, const uint64_t seed,
+	const hash_ty hash, HASHMAP_DATATYPE *const restrict dest,
+	const KEY_TY key
+)
+{
+	const HASHMAP_DATATYPE *const restrict found =
+		stripe->map->seed == seed
+			? HASHMAP_METHODNAME(search_hashed)(stripe->map, hash, key)
+			: HASHMAP_METHODNAME(search)(stripe->map, key);
+
+	/* The data can move once the stripe is unlocked. */
+	if (found && dest)
+		*dest = *found;
+
+	return (found != NULL);
+}
+
+/*!
+ * @brief remove a key from the HashMap of a locked `Stripe`.
+ *
+ * @param stripe the stripe, its lock must be held.
+ * @param seed the seed `hash` was computed with.
+ * @param hash hash of the key.
+ * @param dest address to store the data of the removed key, can be NULL.
+ * @param key the key to remove.
+ * @returns true on success, false on failure.
+ */
+static bool HASHMAP_METHODNAME(stripe_remove)(
+	STRIPE_STRUCT_TAG *const restrict stripe, const uint64_t seed,
+	const hash_ty hash, HASHMAP_DATATYPE *const restrict dest,
+	const KEY_TY key
+)
+{
+	return (
+		stripe->map->seed == seed
+			? HASHMAP_METHODNAME(remove_hashed)(stripe->map, dest, hash, key)
+			: HASHMAP_METHODNAME(remove)(stripe->map, dest, key)
+	);
+}
+
+/*!
+ * @brief count the keys in an array of `Stripe`s.
+ *
+ * @param stripes the stripes.
+ * @param count number of stripes.
+ * @returns the number of keys.
+ */
+static len_ty HASHMAP_METHODNAME(stripes_used)(
+	STRIPE_STRUCT_TAG *const restrict stripes, const len_ty count
+)
+{
+	len_ty used = 0;
+
+	for (len_ty i = 0; i < count; i++)
+	{
+		mtx_lock(&stripes[i].lock);
+		used += HASHMAP_METHODNAME(count)(stripes[i].map);
+		mtx_unlock(&stripes[i].lock);
+	}
+
+	return (used);
+}
+
+/*!
+ * @brief count the Buckets in an array of `Stripe`s.
+ *
+ * @param stripes the stripes.
+ * @param count number of stripes.
+ * @returns the total capacity of the stripes.
+ */
+static len_ty HASHMAP_METHODNAME(stripes_capacity)(
+	STRIPE_STRUCT_TAG *const restrict stripes, const len_ty count
+)
+{
+	len_ty capacity = 0;
+
+	for (len_ty i = 0; i < count; i++)
+	{
+		mtx_lock(&stripes[i].lock);
+		capacity += stripes[i].map->capacity;
+		mtx_unlock(&stripes[i].lock);
+	}
+
+	return (capacity);
+}
+#endif /* defined HASHMAP_CONCURRENT || defined HASHMAP_SHARDED */
+
+#ifdef HASHMAP_CONCURRENT
+/* Concurrent HashMap. */
+
+/* Stripes are picked with the hash bits right below the 7 bits that */
+/* Swiss Table tags are made of, the Buckets with the lowest bits. */
+	#define STRIPE_OF(chm, hash)                                              \
+		(&(chm)->stripes                                                      \
+			  [((hash) >>                                                     \
+				(sizeof(hash_ty) * CHAR_BIT - 7 - (chm)->stripe_bits)) &      \
+			   ((chm)->stripe_count - 1)])
+
+static bool HASHMAP_METHODNAME(concurrent_grow)(
+	CONCURRENT_STRUCT_TAG *const chm, const len_ty capacity
+) _nonnull;
+
+/*!
+ * @brief allocate and initialise a `ConcurrentHashMap`.
+ *
+ * @param capacity total number of Buckets in the stripes.
+ * @param stripes number of stripes, rounded up to a power of 2.
+ * @returns pointer to the concurrent HashMap, NULL on failure.
+ */
+CONCURRENT_STRUCT_TAG *
+HASHMAP_METHODNAME(concurrent_new)(const len_ty capacity, len_ty stripes)
+{
+	if (capacity < 1 || stripes < 1 || stripes > HASHMAP_MAX_STRIPES)
+		return (NULL);
+
+	CONCURRENT_STRUCT_TAG *const restrict chm = xcalloc(1, sizeof(*chm));
+
+	if (!chm)
+		return (NULL);
+
+	while (((len_ty)1 << chm->stripe_bits) < stripes)
+		chm->stripe_bits++;
+
+	stripes = (len_ty)1 << chm->stripe_bits;
+	chm->seed = random_seed(chm);
+	chm->stripes = aligned_alloc(
+		HASHMAP_CACHE_LINE, sizeof(*chm->stripes) * (size_t)stripes
+	);
+	if (!chm->stripes)
+		return (HASHMAP_METHODNAME(concurrent_delete)(chm, NULL));
+
+	const len_ty stripe_capacity = (capacity + stripes - 1) / stripes;
+
+	for (; chm->stripe_count < stripes; chm->stripe_count++)
+	{
+		STRIPE_STRUCT_TAG *const restrict stripe =
+			&chm->stripes[chm->stripe_count];
+
+		if (!HASHMAP_METHODNAME(stripe_init)(stripe, stripe_capacity))
+			return (HASHMAP_METHODNAME(concurrent_delete)(chm, NULL));
+
+		/* One hash picks both the stripe and the Bucket. */
+		stripe->map->seed = chm->seed;
+	}
+
+	return (chm);
+}
+
+/*!
+ * @brief free a `ConcurrentHashMap`, no other thread may be using it.
+ *
+ * @param chm the concurrent HashMap to delete.
+ * @param data_free function that will be used to free the data.
+ * @returns NULL always.
+ */
+void *HASHMAP_METHODNAME(concurrent_delete)(
+	CONCURRENT_STRUCT_TAG *const restrict chm,
+	HM_CONCAT(free_mem_, HASHMAP_UNIQUE_SUFFIX) * data_free
+)
+{
+	if (!chm)
+		return (NULL);
+
+	HASHMAP_METHODNAME(stripes_delete)(
+		chm->stripes, chm->stripe_count, data_free
+	);
+	*chm = (CONCURRENT_STRUCT_TAG){0};
+	xfree(chm);
+	return (NULL);
+}
+
+/*!
+ * @brief double the capacity of the stripes of a `ConcurrentHashMap`.
+ *
+ * Every stripe is locked for the duration, so the stripes keep the same
+ * capacity.
+ *
+ * @param chm the concurrent HashMap to grow.
+ * @param capacity only stripes with at most this capacity are grown, those
+ * grown by another thread in the meantime are left alone.
+ * @returns true on success, false if a stripe could not grow.
+ */
+static bool HASHMAP_METHODNAME(concurrent_grow)(
+	CONCURRENT_STRUCT_TAG *const restrict chm, const len_ty capacity
+)
+{
+	bool grew = true;
+
+	/* The locks are always taken in the same order, so threads growing */
+	/* the stripes at the same time do not deadlock. */
+	for (len_ty i = 0; i < chm->stripe_count; i++)
+		mtx_lock(&chm->stripes[i].lock);
+
+	for (len_ty i = 0; i < chm->stripe_count; i++)
+	{
+		STRIPE_STRUCT_TAG *const restrict stripe = &chm->stripes[i];
+
+		if (stripe->map->capacity > capacity)
+			continue;
+
+		HASHMAP_STRUCT_TAG *const grown = HASHMAP_METHODNAME(resize)(
+			stripe->map, stripe->map->capacity * 2
+		);
+
+		/* A stripe that could not grow is still usable. */
+		if (grown)
+			stripe->map = grown;
+		else
+			grew = false;
+	}
+
+	for (len_ty i = chm->stripe_count; i > 0; i--)
+		mtx_unlock(&chm->stripes[i - 1].lock);
+
+	return (grew);
+}
+
+/*!
+ * @brief insert a key data pair into a `ConcurrentHashMap`.
+ *
+ * @param chm the concurrent HashMap to modify.
+ * @param key the key to insert.
+ * @param data the data to insert.
+ * @returns true on success, false on failure.
+ */
+bool HASHMAP_METHODNAME(concurrent_insert)(
+	CONCURRENT_STRUCT_TAG *const restrict chm, const KEY_TY key,
+	HASHMAP_DATATYPE data
+)
+{
+	if (!chm || !KEY_ISVALID(key))
+		return (false);
+
+	const hash_ty hash = HASHMAP_METHODNAME(hash_key)(chm->seed, key);
+	STRIPE_STRUCT_TAG *const restrict stripe = STRIPE_OF(chm, hash);
+
+	mtx_lock(&stripe->lock);
+	/* Only a new key can fill a stripe. Another thread can fill it again */
+	/* while it is unlocked, so it is checked until it has room. */
+	while (HASHMAP_METHODNAME(next_capacity)(stripe->map) >
+			   stripe->map->capacity &&
+		   !HASHMAP_METHODNAME(stripe_search)(
+			   stripe, chm->seed, hash, NULL, key
+		   ))
+	{
+		const len_ty capacity = stripe->map->capacity;
+
+		mtx_unlock(&stripe->lock);
+		/* Growing the stripe alone would leave it bigger than the rest. */
+		if (!HASHMAP_METHODNAME(concurrent_grow)(chm, capacity))
+			return (false);
+
+		mtx_lock(&stripe->lock);
+	}
+
+	const bool inserted =
+		HASHMAP_METHODNAME(stripe_insert)(stripe, chm->seed, hash, key, data);
+
+	mtx_unlock(&stripe->lock);
+	return (inserted);
+}
+
+/*!
+ * @brief search a `ConcurrentHashMap` for the data of a key.
+ *
+ * @param chm the concurrent HashMap to search.
+ * @param dest address to copy the data of the key to, can be NULL.
+ * @param key the key to search for.
+ * @returns true if the key was found, false otherwise.
+ */
+bool HASHMAP_METHODNAME(concurrent_search)(
+	CONCURRENT_STRUCT_TAG *const restrict chm,
+	HASHMAP_DATATYPE *const restrict dest, const KEY_TY key
+)
+{
+	if (!chm || !KEY_ISVALID(key))
+		return (false);
+
+	const hash_ty hash = HASHMAP_METHODNAME(hash_key)(chm->seed, key);
+	STRIPE_STRUCT_TAG *const restrict stripe = STRIPE_OF(chm, hash);
+
+	mtx_lock(&stripe->lock);
+
+	const bool found =
+		HASHMAP_METHODNAME(stripe_search)(stripe, chm->seed, hash, dest, key);
+
+	mtx_unlock(&stripe->lock);
+	return (found);
+}
+
+/*!
+ * @brief remove a key from a `ConcurrentHashMap`.
+ *
+ * @param chm the concurrent HashMap to modify.
+ * @param dest address to store the data of the removed key, can be NULL.
+ * @param key the key to remove.
+ * @returns true on success, false on failure.
+ */
+bool HASHMAP_METHODNAME(concurrent_remove)(
+	CONCURRENT_STRUCT_TAG *const restrict chm,
+	HASHMAP_DATATYPE *const restrict dest, const KEY_TY key
+)
+{
+	if (!chm || !KEY_ISVALID(key))
+		return (false);
+
+	const hash_ty hash = HASHMAP_METHODNAME(hash_key)(chm->seed, key);
+	STRIPE_STRUCT_TAG *const restrict stripe = STRIPE_OF(chm, hash);
+
+	mtx_lock(&stripe->lock);
+
+	const bool removed =
+		HASHMAP_METHODNAME(stripe_remove)(stripe, chm->seed, hash, dest, key);
+
+	mtx_unlock(&stripe->lock);
+	return (removed);
+}
+
+/*!
+ * @brief count the keys in a `ConcurrentHashMap`.
+ *
+ * @param chm the concurrent HashMap.
+ * @returns the number of keys, -1 on failure.
+ */
+len_ty HASHMAP_METHODNAME(concurrent_used)(
+	CONCURRENT_STRUCT_TAG *const restrict chm
+)
+{
+	if (!chm)
+		return (-1);
+
+	return (
+		HASHMAP_METHODNAME(stripes_used)(chm->stripes, chm->stripe_count)
+	);
+}
+
+/*!
+ * @brief count the Buckets of a `ConcurrentHashMap`.
+ *
+ * @param chm the concurrent HashMap.
+ * @returns the total capacity of the stripes, -1 on failure.
+ */
+len_ty HASHMAP_METHODNAME(concurrent_capacity)(
+	CONCURRENT_STRUCT_TAG *const restrict chm
+)
+{
+	if (!chm)
+		return (-1);
+
+	return (
+		HASHMAP_METHODNAME(stripes_capacity)(chm->stripes, chm->stripe_count)
+	);
+}
+
+	#undef STRIPE_OF
+#endif /* HASHMAP_CONCURRENT */
+
+#ifdef HASHMAP_SHARDED
+/* Sharded HashMap. */
+
+/* The top bits of the hash pick the shard. Shifting twice keeps the shift */
+/* narrower than the hash when there is a single shard. */
+	#define SHARD_OF(shm, hash)                                               \
+		(&(shm)->shards                                                       \
+			  [(hash) >> 1 >>                                                 \
+			   (sizeof(hash_ty) * CHAR_BIT - 1 - (shm)->shard_bits)])
+
+/*!
+ * @brief allocate and initialise a `ShardedHashMap`.
+ *
+ * @param capacity total number of Buckets in the shards.
+ * @param bits number of hash bits that select a shard, there are 2 to the
+ * power of `bits` shards.
+ * @returns pointer to the sharded HashMap, NULL on failure.
+ */
+SHARDED_STRUCT_TAG *
+HASHMAP_METHODNAME(sharded_new)(const len_ty capacity, const unsigned int bits)
+{
+	if (capacity < 1 || bits > HASHMAP_MAX_SHARD_BITS)
+		return (NULL);
+
+	SHARDED_STRUCT_TAG *const restrict shm = xcalloc(1, sizeof(*shm));
+
+	if (!shm)
+		return (NULL);
+
+	const len_ty shards = (len_ty)1 << bits;
+
+	shm->shard_bits = bits;
+	shm->seed = random_seed(shm);
+	shm->shards = aligned_alloc(
+		HASHMAP_CACHE_LINE, sizeof(*shm->shards) * (size_t)shards
+	);
+	if (!shm->shards)
+		return (HASHMAP_METHODNAME(sharded_delete)(shm, NULL));
+
+	const len_ty shard_capacity = (capacity + shards - 1) / shards;
+
+	for (; shm->shard_count < shards; shm->shard_count++)
+	{
+		STRIPE_STRUCT_TAG *const restrict shard =
+			&shm->shards[shm->shard_count];
+
+		if (!HASHMAP_METHODNAME(stripe_init)(shard, shard_capacity))
+			return (HASHMAP_METHODNAME(sharded_delete)(shm, NULL));
+
+		/* One hash picks both the shard and the Bucket, except that the */
+		/* keys of a shard would all share the top bits of their Swiss */
+		/* Table tags, so there the shards hash with their own seeds. */
+	#ifndef SWISS_TABLE_PROBING
+		shard->map->seed = shm->seed;
+	#endif /* SWISS_TABLE_PROBING */
+	}
+
+	return (shm);
+}
+
+/*!
+ * @brief free a `ShardedHashMap`, no other thread may be using it.
+ *
+ * @param shm the sharded HashMap to delete.
+ * @param data_free function that will be used to free the data.
+ * @returns NULL always.
+ */
+void *HASHMAP_METHODNAME(sharded_delete)(
+	SHARDED_STRUCT_TAG *const restrict shm,
+	HM_CONCAT(free_mem_, HASHMAP_UNIQUE_SUFFIX) * data_free
+)
+{
+	if (!shm)
+		return (NULL);
+
+	HASHMAP_METHODNAME(stripes_delete)(
+		shm->shards, shm->shard_count, data_free
+	);
+	*shm = (SHARDED_STRUCT_TAG){0};
+	xfree(shm);
+	return (NULL);
+}
+
+/*!
+ * @brief insert a key data pair into a `ShardedHashMap`.
+ *
+ * A full shard doubles its capacity while only its own lock is held, the
+ * other shards stay usable.
+ *
+ * @param shm the sharded HashMap to modify.
+ * @param key the key to insert.
+ * @param data the data to insert.
+ * @returns true on success, false on failure.
+ */
+bool HASHMAP_METHODNAME(sharded_insert)(
+	SHARDED_STRUCT_TAG *const restrict shm, const KEY_TY key,
+	HASHMAP_DATATYPE data
+)
+{
+	if (!shm || !KEY_ISVALID(key))
+		return (false);
+
+	const hash_ty hash = HASHMAP_METHODNAME(hash_key)(shm->seed, key);
+	STRIPE_STRUCT_TAG *const restrict shard = SHARD_OF(shm, hash);
+
+	mtx_lock(&shard->lock);
+
+	const bool inserted =
+		HASHMAP_METHODNAME(stripe_insert)(shard, shm->seed, hash, key, data);
+
+	mtx_unlock(&shard->lock);
+	return (inserted);
+}
+
+/*!
+ * @brief search a `ShardedHashMap` for the data of a key.
+ *
+ * @param shm the sharded HashMap to search.
+ * @param dest address to copy the data of the key to, can be NULL.
+ * @param key the key to search for.
+ * @returns true if the key was found, false otherwise.
+ */
+bool HASHMAP_METHODNAME(sharded_search)(
+	SHARDED_STRUCT_TAG *const restrict shm,
+	HASHMAP_DATATYPE *const restrict dest, const KEY_TY key
+)
+{
+	if (!shm || !KEY_ISVALID(key))
+		return (false);
+
+	const hash_ty hash = HASHMAP_METHODNAME(hash_key)(shm->seed, key);
+	STRIPE_STRUCT_TAG *const restrict shard = SHARD_OF(shm, hash);
+
+	mtx_lock(&shard->lock);
+
+	const bool found =
+		HASHMAP_METHODNAME(stripe_search)(shard, shm->seed, hash, dest, key);
+
+	mtx_unlock(&shard->lock);
+	return (found);
+}
+
+/*!
+ * @brief remove a key from a `ShardedHashMap`.
+ *
+ * @param shm the sharded HashMap to modify.
+ * @param dest address to store the data of the removed key, can be NULL.
+ * @param key the key to remove.
+ * @returns true on success, false on failure.
+ */
+bool HASHMAP_METHODNAME(sharded_remove)(
+	SHARDED_STRUCT_TAG *const restrict shm,
+	HASHMAP_DATATYPE *const restrict dest, const KEY_TY key
+)
+{
+	if (!shm || !KEY_ISVALID(key))
+		return (false);
+
+	const hash_ty hash = HASHMAP_METHODNAME(hash_key)(shm->seed, key);
+	STRIPE_STRUCT_TAG *const restrict shard = SHARD_OF(shm, hash);
+
+	mtx_lock(&shard->lock);
+
+	const bool removed =
+		HASHMAP_METHODNAME(stripe_remove)(shard, shm->seed, hash, dest, key);
+
+	#ifdef HASHMAP_AUTO_SHRINK
+	HASHMAP_STRUCT_TAG *const trimmed = HASHMAP_METHODNAME(trim)(shard->map);
+
+	/* A shard that could not shrink is still usable. */
+	if (trimmed)
+		shard->map = trimmed;
+
+	#endif /* HASHMAP_AUTO_SHRINK */
+	mtx_unlock(&shard->lock);
+	return (removed);
+}
+
+/*!
+ * @brief count the keys in a `ShardedHashMap`.
+ *
+ * @param shm the sharded HashMap.
+ * @returns the number of keys, -1 on failure.
+ */
+len_ty HASHMAP_METHODNAME(sharded_used)(SHARDED_STRUCT_TAG *const restrict shm)
+{
+	if (!shm)
+		return (-1);
+
+	return (HASHMAP_METHODNAME(stripes_used)(shm->shards, shm->shard_count));
+}
+
+/*!
+ * @brief count the Buckets of a `ShardedHashMap`.
+ *
+ * @param shm the sharded HashMap.
+ * @returns the total capacity of the shards, -1 on failure.
+ */
+len_ty HASHMAP_METHODNAME(sharded_capacity)(
+	SHARDED_STRUCT_TAG *const restrict shm
+)
+{
+	if (!shm)
+		return (-1);
+
+	return (
+		HASHMAP_METHODNAME(stripes_capacity)(shm->shards, shm->shard_count)
+	);
+}
+
+	#undef SHARD_OF
+#endif /* HASHMAP_SHARDED */
+
+#ifdef HASHMAP_RCU
+/* RCU HashMap. */
+
+static len_ty HASHMAP_METHODNAME(reader_slot)(void);
+static HASHMAP_STRUCT_TAG *
+	HASHMAP_METHODNAME(rcu_copy)(RCU_STRUCT_TAG *const rmh) _nonnull;
+static void HASHMAP_METHODNAME(rcu_publish)(
+	RCU_STRUCT_TAG *const rmh, HASHMAP_STRUCT_TAG *const hm,
+	BUCKET_STRUCT_TAG *const retired
+) _nonnull_pos(1);
+
+/*!
+ * @brief allocate and initialise an `RcuHashMap`.
+ *
+ * @param capacity number of Buckets the HashMap will contain.
+ * @returns pointer to the RCU HashMap, NULL on failure.
+ */
+RCU_STRUCT_TAG *HASHMAP_METHODNAME(rcu_new)(const len_ty capacity)
+{
+	RCU_STRUCT_TAG *const restrict rmh =
+		aligned_alloc(HASHMAP_CACHE_LINE, sizeof(*rmh));
+
+	if (!rmh)
+		return (NULL);
+
+	HASHMAP_STRUCT_TAG *const restrict hm = HASHMAP_METHODNAME(new)(capacity);
+
+	if (!hm || mtx_init(&rmh->write_lock, mtx_plain) != thrd_success)
+	{
+		HASHMAP_METHODNAME(delete)(hm, NULL);
+		free(rmh);
+		return (NULL);
+	}
+
+	atomic_init(&rmh->map, hm);
+	atomic_init(&rmh->epoch, 0);
+	for (len_ty i = 0; i < HASHMAP_READER_SLOTS; i++)
+	{
+		atomic_init(&rmh->readers[i].active[0], 0);
+		atomic_init(&rmh->readers[i].active[1], 0);
+	}
+
+	return (rmh);
+}
+
+/*!
+ * @brief free an `RcuHashMap`, no other thread may be using it.
+ *
+ * @param rmh the RCU HashMap to delete.
+ * @param data_free function that will be used to free the data.
+ * @returns NULL always.
+ */
+void *HASHMAP_METHODNAME(rcu_delete)(
+	RCU_STRUCT_TAG *const restrict rmh,
+	HM_CONCAT(free_mem_, HASHMAP_UNIQUE_SUFFIX) * data_free
+)
+{
+	if (!rmh)
+		return (NULL);
+
+	HASHMAP_METHODNAME(delete)(atomic_load(&rmh->map), data_free);
+	mtx_destroy(&rmh->write_lock);
+	free(rmh);
+	return (NULL);
+}
+
+/*!
+ * @brief get the reader slot of the calling thread.
+ *
+ * @returns index of the slot, the same for every call from a thread.
+ */
+static len_ty HASHMAP_METHODNAME(reader_slot)(void)
+{
+	static atomic_uint_fast32_t next_slot;
+	static _Thread_local len_ty slot = -1;
+
+	if (slot < 0)
+		slot = atomic_fetch_add(&next_slot, 1) % HASHMAP_READER_SLOTS;
+
+	return (slot);
+}
+
+/*!
+ * @brief start a write to an `RcuHashMap`.
+ *
+ * The write lock is held until `rcu_publish` is called. The copy shares the
+ * keys and data of the published HashMap, it is freed with `release`.
+ *
+ * @param rmh the RCU HashMap.
+ * @returns a copy of the published HashMap, NULL on failure.
+ */
+static HASHMAP_STRUCT_TAG *
+HASHMAP_METHODNAME(rcu_copy)(RCU_STRUCT_TAG *const restrict rmh)
+{
+	mtx_lock(&rmh->write_lock);
+
+	HASHMAP_STRUCT_TAG *const restrict cpy = HASHMAP_METHODNAME(copy_table)(
+		atomic_load(&rmh->map), NULL, NULL, true
+	);
+
+	if (!cpy)
+		mtx_unlock(&rmh->write_lock);
+
+	return (cpy);
 }
 
 /*!
- * @brief unlink a bucket node from a linked list.
+ * @brief finish a write to an `RcuHashMap`.
  *
- * @param hm pointer to the HashMap the bucket is in.
- * @param bkt pointer to the bucket.
+ * The previously published HashMap is freed after every search that could
+ * still be reading it has returned. Its keys are shared with `hm`, so only
+ * the key of `retired` is freed with it.
+ *
+ * @param rmh the RCU HashMap.
+ * @param hm the HashMap to publish, NULL to leave the RCU HashMap as it is.
+ * @param retired the Bucket of the key removed by the write, NULL if none.
  */
-static void BUCKET_METHODNAME(unlink)(
-	HASHMAP_STRUCT_TAG *const restrict hm,
-	BUCKET_STRUCT_TAG *const restrict bkt
+static void HASHMAP_METHODNAME(rcu_publish)(
+	RCU_STRUCT_TAG *const restrict rmh, HASHMAP_STRUCT_TAG *const restrict hm,
+	BUCKET_STRUCT_TAG *const restrict retired
 )
 {
-#ifdef EMPTY_BUCKET_STACK
-	if (POS_TO_PTR(hm->arr, hm->top_pos) == bkt)
-		hm->top_pos = bkt->next_pos;
+	if (hm)
+	{
+	#ifdef INCREMENTAL_RESIZE
+		/* Searches of a published HashMap do not migrate its Buckets. */
+		HASHMAP_METHODNAME(migrate)(hm, LEN_TY_max);
+	#endif /* INCREMENTAL_RESIZE */
+		HASHMAP_STRUCT_TAG *const old = atomic_exchange(&rmh->map, hm);
+		/* Searches that might have loaded `old` counted themselves in */
+		/* this epoch, later ones count in the next. */
+		const uint_fast64_t epoch = atomic_fetch_add(&rmh->epoch, 1);
+
+		for (len_ty i = 0; i < HASHMAP_READER_SLOTS; i++)
+		{
+			while (atomic_load(&rmh->readers[i].active[epoch & 1]) > 0)
+				thrd_yield();
+		}
 
-#endif /* EMPTY_BUCKET_STACK */
-	const unsigned int next_pos = bkt->next_pos;
-	const unsigned int prev_pos = bkt->prev_pos;
-	if (next_pos)
-		POS_TO_PTR(hm->arr, next_pos)->prev_pos = prev_pos;
+		if (retired)
+			BUCKET_METHODNAME(freekey)(retired, old->alloc);
 
-	if (prev_pos)
-		POS_TO_PTR(hm->arr, prev_pos)->next_pos = next_pos;
+		HASHMAP_METHODNAME(release)(old);
+	}
 
-	bkt->next_pos = 0;
-	bkt->prev_pos = 0;
+	mtx_unlock(&rmh->write_lock);
 }
 
 /*!
- * @brief search a `HashMap` for an empty `Bucket`.
+ * @brief insert a key data pair into an `RcuHashMap`.
  *
- * The Cellar if available will be searched first.
- *
- * @param hm the HashMap to search.
- * @returns pointer to an empty Bucket, NULL if none.
+ * @param rmh the RCU HashMap to modify.
+ * @param key the key to insert.
+ * @param data the data to insert.
+ * @returns true on success, false on failure.
  */
-static BUCKET_STRUCT_TAG *
-HASHMAP_METHODNAME(get_empty)(HASHMAP_STRUCT_TAG *const restrict hm)
+bool HASHMAP_METHODNAME(rcu_insert)(
+	RCU_STRUCT_TAG *const restrict rmh, const KEY_TY key,
+	HASHMAP_DATATYPE data
+)
 {
-	BUCKET_STRUCT_TAG *restrict empty_bucket = NULL;
-#ifdef EMPTY_BUCKET_STACK
-
-	if (hm->top_pos)
-	{
-		empty_bucket = POS_TO_PTR(hm->arr, hm->top_pos);
-		BUCKET_METHODNAME(unlink)(hm, empty_bucket);
-	}
-#else
-	len_ty i = 0;
+	if (!rmh || !KEY_ISVALID(key))
+		return (false);
 
-	#ifdef CELLAR_COALESCED_HASHING
-	/* Check the cellar first if it has unused slots. */
-	if (hm->cellar.used < hm->cellar.capacity)
-		i += hm->cellar.capacity;
-	#endif /* CELLAR_COALESCED_HASHING */
+	HASHMAP_STRUCT_TAG *restrict cpy = HASHMAP_METHODNAME(rcu_copy)(rmh);
 
-	if (hm->used < hm->capacity || i > 0)
-		i += hm->capacity;
+	if (!cpy)
+		return (false);
 
-	while (i > 0)
-	{
-		i--;
-		if (BUCKET_METHODNAME(islive)(hm->arr[i]) == false)
-		{
-			empty_bucket = &hm->arr[i];
-			break;
-		}
-	}
-#endif     /* EMPTY_BUCKET_STACK */
+	/* An existing key keeps its block, so no key is retired. */
+	const bool inserted =
+		HASHMAP_METHODNAME(insert)(&cpy, key, data) != NULL;
 
-	if (empty_bucket)
-		*empty_bucket = (BUCKET_STRUCT_TAG){0};
+	if (!inserted)
+		cpy = HASHMAP_METHODNAME(release)(cpy);
 
-	return (empty_bucket);
+	HASHMAP_METHODNAME(rcu_publish)(rmh, cpy, NULL);
+	return (inserted);
 }
 
 /*!
- * @brief insert a `Bucket` into a `HashMap`.
+ * @brief search an `RcuHashMap` for the data of a key without locking.
  *
- * @param hm pointer to the HashMap.
- * @returns pointer to the inserted Bucket, NULL if there are no more slots.
+ * @param rmh the RCU HashMap to search.
+ * @param dest address to copy the data of the key to, can be NULL.
+ * @param key the key to search for.
+ * @returns true if the key was found, false otherwise.
  */
-static BUCKET_STRUCT_TAG *HASHMAP_METHODNAME(place)(
-	HASHMAP_STRUCT_TAG *const restrict hm, BUCKET_STRUCT_TAG bucket
+bool HASHMAP_METHODNAME(rcu_search)(
+	RCU_STRUCT_TAG *const restrict rmh, HASHMAP_DATATYPE *const restrict dest,
+	const KEY_TY key
 )
 {
-	const len_ty index = FOLD(bucket.hash, hm->capacity);
-
-	bucket.next_pos = 0;
-	bucket.prev_pos = 0;
-	if (BUCKET_METHODNAME(islive)(hm->arr[index]) == false)
-	{
-#ifdef EMPTY_BUCKET_STACK
-		BUCKET_METHODNAME(unlink)(hm, &hm->arr[index]);
-#endif /* EMPTY_BUCKET_STACK */
-		hm->arr[index] = bucket;
-		hm->used++;
-		return (&hm->arr[index]);
-	}
+	if (!rmh || !KEY_ISVALID(key))
+		return (false);
 
-	BUCKET_STRUCT_TAG *const restrict alt_bucket =
-		HASHMAP_METHODNAME(get_empty)(hm);
-	if (!alt_bucket)
-		return (NULL);
+	READER_STRUCT_TAG *const restrict reader =
+		&rmh->readers[HASHMAP_METHODNAME(reader_slot)()];
+	uint_fast64_t epoch;
 
-	/* Insert the bucket at the end of the chain. */
-	for (BUCKET_STRUCT_TAG *restrict walk = &hm->arr[index]; walk;)
+	/* Retry if a writer moved to the next epoch before this reader was */
+	/* counted, the writer might not have seen the count. */
+	for (;;)
 	{
-		if (!walk->next_pos)
-		{
-			walk->next_pos = PTR_TO_POS(hm->arr, alt_bucket);
-			bucket.prev_pos = PTR_TO_POS(hm->arr, walk);
+		epoch = atomic_load(&rmh->epoch);
+		atomic_fetch_add(&reader->active[epoch & 1], 1);
+		if (atomic_load(&rmh->epoch) == epoch)
 			break;
-		}
 
-		walk = POS_TO_PTR(hm->arr, walk->next_pos);
+		atomic_fetch_sub(&reader->active[epoch & 1], 1);
 	}
 
-	*alt_bucket = bucket;
-#ifdef CELLAR_COALESCED_HASHING
-	if (hm->cellar.capacity > 0 && alt_bucket >= &hm->arr[hm->capacity])
-		hm->cellar.used++;
-	else
-#endif /* CELLAR_COALESCED_HASHING */
-		hm->used++;
+	HASHMAP_STRUCT_TAG *const restrict hm = atomic_load(&rmh->map);
+	const BUCKET_STRUCT_TAG *const restrict bucket =
+		HASHMAP_METHODNAME(search_key)(
+			hm, HASHMAP_METHODNAME(hash_key)(hm->seed, key), key, NULL
+		);
 
-	return (alt_bucket);
+	if (bucket && dest)
+		*dest = bucket->data;
+
+	atomic_fetch_sub(&reader->active[epoch & 1], 1);
+	return (bucket != NULL);
 }
 
 /*!
- * @brief insert a key data pair into a HashMap.
- *
- * The capacity of the HashMap will be doubled if the load factor is high.
+ * @brief remove a key from an `RcuHashMap`.
  *
- * @param hm address of the pointer to the HashMap to modify.
- * @param key the key to insert.
- * @param data the data to insert.
- * @returns pointer to the data inserted, NULL on failure.
+ * @param rmh the RCU HashMap to modify.
+ * @param dest address to store the data of the removed key, can be NULL.
+ * @param key the key to remove.
+ * @returns true on success, false on failure.
  */
-HASHMAP_DATATYPE *HASHMAP_METHODNAME(insert)(
-	HASHMAP_STRUCT_TAG *restrict *const hm, const u8mem key,
-	HASHMAP_DATATYPE data
+bool HASHMAP_METHODNAME(rcu_remove)(
+	RCU_STRUCT_TAG *const restrict rmh, HASHMAP_DATATYPE *const restrict dest,
+	const KEY_TY key
 )
 {
-	if (!hm || !*hm || HASHMAP_METHODNAME(isvalid)(*hm) == false || !key.buf ||
-		key.len < 1)
-		return (NULL);
+	if (!rmh || !KEY_ISVALID(key))
+		return (false);
 
-	hash_ty hash;
+	HASHMAP_STRUCT_TAG *restrict cpy = HASHMAP_METHODNAME(rcu_copy)(rmh);
 
-	if (!HASHMAP_METHODNAME(hash)(&hash, key))
-		return (NULL);
+	if (!cpy)
+		return (false);
 
-	HASHMAP_STRUCT_TAG *map = *hm;
-	BUCKET_STRUCT_TAG *restrict bucket =
-		HASHMAP_METHODNAME(search_key)(map, hash, key);
+	/* The key is still read by searches of the published HashMap, it is */
+	/* only taken out of the copy and freed once they are done. */
+	BUCKET_STRUCT_TAG *const restrict hole = HASHMAP_METHODNAME(search_key)(
+		cpy, HASHMAP_METHODNAME(hash_key)(cpy->seed, key), key, NULL
+	);
 
-	if (bucket)
+	if (!hole)
 	{
-		bucket->data = data;
-		return (&bucket->data);
+		HASHMAP_METHODNAME(release)(cpy);
+		HASHMAP_METHODNAME(rcu_publish)(rmh, NULL, NULL);
+		return (false);
 	}
 
-	u8mem *const restrict key_dup = u8mem_new(key.buf, key.len);
+	BUCKET_STRUCT_TAG retired = *hole;
 
-	if (!key_dup)
-		return (NULL);
+	if (dest)
+		*dest = retired.data;
 
-	map = HASHMAP_METHODNAME(double_capacity)(map);
-	if (!map)
-		return (u8mem_delete(key_dup));
+	BUCKET_METHODNAME(count_key)(hole, &cpy->key_bytes, &cpy->key_blocks, -1);
+	HASHMAP_METHODNAME(evict)(cpy, hole);
+	#ifdef HASHMAP_AUTO_SHRINK
+	HASHMAP_STRUCT_TAG *const trimmed = HASHMAP_METHODNAME(trim)(cpy);
 
-	bucket = HASHMAP_METHODNAME(place)(
-		map, (BUCKET_STRUCT_TAG){.data = data, .hash = hash, .key = key_dup}
-	);
-	*hm = map;
-	return (&bucket->data);
+	/* The copy is published as it is if it could not shrink. */
+	if (trimmed)
+		cpy = trimmed;
+
+	#endif /* HASHMAP_AUTO_SHRINK */
+	HASHMAP_METHODNAME(rcu_publish)(rmh, cpy, &retired);
+	return (true);
 }
 
 /*!
- * @brief remove the `Bucket` containing the given key.
+ * @brief grow the capacity of an `RcuHashMap` to the given capacity.
  *
- * @param hm pointer to the HashMap to edit.
- * @param dest address to store the data in the Bucket.
- * @param key the key of the bucket to remove.
+ * @param rmh the RCU HashMap to grow.
+ * @param capacity the new capacity.
  * @returns true on success, false on failure.
  */
-bool HASHMAP_METHODNAME(remove)(
-	HASHMAP_STRUCT_TAG *restrict hm, HASHMAP_DATATYPE *const restrict dest,
-	const u8mem key
+bool HASHMAP_METHODNAME(rcu_grow)(
+	RCU_STRUCT_TAG *const restrict rmh, const len_ty capacity
 )
 {
-	if (!hm || HASHMAP_METHODNAME(isvalid)(hm) == false || !key.buf ||
-		key.len < 1)
+	if (!rmh || capacity < 1)
 		return (false);
 
-	hash_ty hash;
-
-	if (!HASHMAP_METHODNAME(hash)(&hash, key))
-		return (false);
+	HASHMAP_STRUCT_TAG *const restrict cpy = HASHMAP_METHODNAME(rcu_copy)(rmh);
 
-	BUCKET_STRUCT_TAG *restrict removed =
-		HASHMAP_METHODNAME(search_key)(hm, hash, key);
-	if (!removed)
+	if (!cpy)
 		return (false);
 
-	BUCKET_STRUCT_TAG *restrict walk = POS_TO_PTR(hm->arr, removed->next_pos);
-
-	BUCKET_METHODNAME(unlink)(hm, removed);
-	if (dest)
-		*dest = removed->data;
+	HASHMAP_STRUCT_TAG *const restrict grown =
+		HASHMAP_METHODNAME(grow)(cpy, capacity);
 
-	*removed = (BUCKET_STRUCT_TAG){.key = u8mem_delete(removed->key)};
-	while (walk)
+	/* Big enough already, or the copy could not grow. */
+	if (grown == cpy || !grown)
 	{
-		BUCKET_STRUCT_TAG *const restrict next =
-			POS_TO_PTR(hm->arr, walk->next_pos);
-		BUCKET_STRUCT_TAG *restrict new_spot =
-			&hm->arr[FOLD(walk->hash, hm->capacity)];
+		HASHMAP_METHODNAME(release)(cpy);
+		HASHMAP_METHODNAME(rcu_publish)(rmh, NULL, NULL);
+		return (grown != NULL);
+	}
 
-		walk->prev_pos = 0;
-		if (BUCKET_METHODNAME(islive)(*new_spot) == true)
-		{ /* place bucket at end of the chain. */
-			while (new_spot->next_pos)
-				new_spot = POS_TO_PTR(hm->arr, new_spot->next_pos);
+	HASHMAP_METHODNAME(rcu_publish)(rmh, grown, NULL);
+	return (true);
+}
+#endif /* HASHMAP_RCU */
 
-			new_spot->next_pos = PTR_TO_POS(hm->arr, walk);
-			walk->prev_pos = PTR_TO_POS(hm->arr, new_spot);
-			new_spot = walk;
-		}
-		else
-		{ /* place bucket at the start of chain and update the hole's position. */
-			*new_spot = *walk;
-			removed = walk;
-			*removed = (BUCKET_STRUCT_TAG){0};
-		}
+#ifdef HASHMAP_HANDLE
+/* HashMap handle. */
 
-		new_spot->next_pos = 0;
-		walk = next;
-	}
+/*!
+ * @brief allocate and initialise a `HashMapHandle`.
+ *
+ * @param capacity number of Buckets the HashMap will contain.
+ * @returns pointer to the handle, NULL on failure.
+ */
+HANDLE_STRUCT_TAG *HASHMAP_METHODNAME(handle_new)(const len_ty capacity)
+{
+	HANDLE_STRUCT_TAG *const restrict hmh = xcalloc(1, sizeof(*hmh));
 
-#ifdef EMPTY_BUCKET_STACK
-	removed->next_pos = hm->top_pos;
-	hm->top_pos = PTR_TO_POS(hm->arr, removed);
-#endif /* EMPTY_BUCKET_STACK */
-#ifdef CELLAR_COALESCED_HASHING
-	if (hm->cellar.capacity > 0 && removed >= &hm->arr[hm->capacity])
-		hm->cellar.used--;
-	else
-#endif /* CELLAR_COALESCED_HASHING */
-		hm->used--;
+	if (!hmh)
+		return (NULL);
 
-	return (true);
+	hmh->map = HASHMAP_METHODNAME(new)(capacity);
+	if (!hmh->map)
+		return (HASHMAP_METHODNAME(handle_delete)(hmh, NULL));
+
+	return (hmh);
 }
 
 /*!
- * @brief write the string representation of a `Bucket` into a buffer.
+ * @brief free a `HashMapHandle` and its HashMap.
  *
- * @param bucket the Bucket.
- * @param buf the char buffer.
- * @param i cursor into the buffer.
- * @param data_tostr pointer to a function that can stringify the data in
- * the Bucket.
- * @returns pointer to the buffer, NULL on error.
+ * @param hmh the handle to delete.
+ * @param data_free function that will be used to free the data.
+ * @returns NULL always.
  */
-static char *BUCKET_METHODNAME(tostr)(
-	const BUCKET_STRUCT_TAG bucket,
-	HM_CONCAT(stringify_data_, HASHMAP_UNIQUE_SUFFIX) * data_tostr
+void *HASHMAP_METHODNAME(handle_delete)(
+	HANDLE_STRUCT_TAG *const restrict hmh,
+	HM_CONCAT(free_mem_, HASHMAP_UNIQUE_SUFFIX) * data_free
 )
 {
-	char *const restrict key_str = u8mem_tostr(*bucket.key);
-	char *const restrict data_str = data_tostr(bucket.data);
-	char *restrict bucket_str = NULL;
-
-	if (!key_str || !data_str)
-		goto cleanup;
+	if (!hmh)
+		return (NULL);
 
-	const long int len = snprintf(NULL, 0, "%s: %s", key_str, data_str) + 1;
+	HASHMAP_METHODNAME(delete)(hmh->map, data_free);
+	*hmh = (HANDLE_STRUCT_TAG){0};
+	return (xfree(hmh));
+}
 
-	if (len < 1)
-		goto cleanup;
+/*!
+ * @brief insert a key data pair into the HashMap of a `HashMapHandle`.
+ *
+ * @param hmh the handle.
+ * @param key the key to insert.
+ * @param data the data to insert.
+ * @returns pointer to the data in the HashMap, valid until the handle is
+ * modified again. NULL on failure.
+ */
+HASHMAP_DATATYPE *HASHMAP_METHODNAME(handle_insert)(
+	HANDLE_STRUCT_TAG *const restrict hmh, const KEY_TY key,
+	HASHMAP_DATATYPE data
+)
+{
+	if (!hmh)
+		return (NULL);
 
-	bucket_str = xmalloc(len);
-	if (!bucket_str)
-		goto cleanup;
+	return (HASHMAP_METHODNAME(insert)(&hmh->map, key, data));
+}
 
-	if (snprintf(bucket_str, len, "%s: %s", key_str, data_str) < 0)
-		bucket_str = xfree(bucket_str);
+/*!
+ * @brief search the HashMap of a `HashMapHandle` for the data of a key.
+ *
+ * @param hmh the handle.
+ * @param key the key to search for.
+ * @returns pointer to the data of the key, NULL if it was not found.
+ */
+HASHMAP_DATATYPE *HASHMAP_METHODNAME(handle_search)(
+	HANDLE_STRUCT_TAG *const restrict hmh, const KEY_TY key
+)
+{
+	if (!hmh)
+		return (NULL);
 
-cleanup:
-	xfree(key_str);
-	xfree(data_str);
-	return (bucket_str);
+	return (HASHMAP_METHODNAME(search)(hmh->map, key));
 }
 
 /*!
- * @brief return the string representation of a `HashMap`.
+ * @brief remove a key from the HashMap of a `HashMapHandle`.
  *
- * @param hm the HashMap to stringify.
- * @param data_tostr pointer to a function that can stringify the data in
- * the Buckets.
- * @returns pointer to the stringified data, NULL on failure.
+ * @param hmh the handle.
+ * @param dest address to store the data of the removed key, can be NULL.
+ * @param key the key to remove.
+ * @returns true on success, false on failure.
  */
-char *HASHMAP_METHODNAME(tostr)(
-	const HASHMAP_STRUCT_TAG *const restrict hm,
-	HM_CONCAT(stringify_data_, HASHMAP_UNIQUE_SUFFIX) * data_tostr
+bool HASHMAP_METHODNAME(handle_remove)(
+	HANDLE_STRUCT_TAG *const restrict hmh,
+	HASHMAP_DATATYPE *const restrict dest, const KEY_TY key
 )
 {
-	if (HASHMAP_METHODNAME(isvalid)(hm) == false || !data_tostr)
-		return (NULL);
+	if (!hmh)
+		return (false);
 
-	char *restrict hm_str = xcalloc(3, sizeof(*hm_str));
+	const bool removed = HASHMAP_METHODNAME(remove)(hmh->map, dest, key);
 
-	if (!hm_str)
-		return (NULL);
+	#ifdef HASHMAP_AUTO_SHRINK
+	HASHMAP_STRUCT_TAG *const trimmed =
+		removed ? HASHMAP_METHODNAME(trim)(hmh->map) : NULL;
 
-	hm_str[0] = '{';
-	size_t s_len = 1;
-#ifdef CELLAR_COALESCED_HASHING
-	const len_ty end = hm->capacity + hm->cellar.capacity;
-#else
-	const len_ty end = hm->capacity;
-#endif /* CELLAR_COALESCED_HASHING */
+	/* Trimming is only an optimisation, the HashMap is kept on failure. */
+	if (trimmed)
+		hmh->map = trimmed;
 
-	for (len_ty i = 0; hm_str && i < end; i++)
-	{
-		if (BUCKET_METHODNAME(islive)(hm->arr[i]) == false)
-			continue;
+	#endif /* HASHMAP_AUTO_SHRINK */
+	return (removed);
+}
+
+/*!
+ * @brief grow the HashMap of a `HashMapHandle` to the given capacity.
+ *
+ * @param hmh the handle.
+ * @param capacity the new capacity.
+ * @returns true on success, false on failure.
+ */
+bool HASHMAP_METHODNAME(handle_grow)(
+	HANDLE_STRUCT_TAG *const restrict hmh, const len_ty capacity
+)
+{
+	if (!hmh)
+		return (false);
 
-		char *const restrict bucket_str =
-			BUCKET_METHODNAME(tostr)(hm->arr[i], data_tostr);
+	HASHMAP_STRUCT_TAG *const grown =
+		HASHMAP_METHODNAME(grow)(hmh->map, capacity);
 
-		if (!bucket_str)
-			return (xfree(hm_str));
+	if (!grown)
+		return (false);
+
+	hmh->map = grown;
+	return (true);
+}
 
-		size_t b_len = strlen(bucket_str) + 2;
+/*!
+ * @brief shrink the HashMap of a `HashMapHandle` to the given capacity.
+ *
+ * @param hmh the handle.
+ * @param capacity the new capacity, raised to fit the keys.
+ * @returns true on success, false on failure.
+ */
+bool HASHMAP_METHODNAME(handle_shrink)(
+	HANDLE_STRUCT_TAG *const restrict hmh, const len_ty capacity
+)
+{
+	if (!hmh)
+		return (false);
 
-		if (i < end - 1)
-			b_len++;
+	HASHMAP_STRUCT_TAG *const shrunk =
+		HASHMAP_METHODNAME(shrink)(hmh->map, capacity);
 
-		hm_str = xrealloc_free_on_fail(hm_str, s_len + b_len);
-		if (hm_str)
-		{
-			if (i < end - 1)
-				sprintf(hm_str + s_len, "%s, ", bucket_str);
-			else
-				sprintf(hm_str + s_len, "%s}", bucket_str);
+	if (!shrunk)
+		return (false);
 
-			s_len += b_len;
-		}
+	hmh->map = shrunk;
+	return (true);
+}
 
-		xfree(bucket_str);
-	}
+/*!
+ * @brief get the HashMap of a `HashMapHandle`.
+ *
+ * The HashMap can be passed to the functions that do not replace it, such
+ * as `tostr` and `search_batch`. It is only valid until the next insert,
+ * remove or resize through the handle.
+ *
+ * @param hmh the handle.
+ * @returns pointer to the HashMap, NULL on failure.
+ */
+HASHMAP_STRUCT_TAG *
+HASHMAP_METHODNAME(handle_map)(const HANDLE_STRUCT_TAG *const restrict hmh)
+{
+	if (!hmh)
+		return (NULL);
 
-	return (hm_str);
+	return (hmh->map);
 }
+#endif /* HASHMAP_HANDLE */
 
 #undef FOLD
+#undef OCCUPANCY_BITMAP
+#undef KEY_TY
+#undef KEY_ISVALID
+#undef KEY_EQ
+#undef INTERNED_STRUCT_TAG
+#undef STRIPE_STRUCT_TAG
+#undef CONCURRENT_STRUCT_TAG
+#undef SHARDED_STRUCT_TAG
+#undef GROW_TASK_STRUCT_TAG
+#undef READER_STRUCT_TAG
+#undef RCU_STRUCT_TAG
+#undef HANDLE_STRUCT_TAG
 
 #undef HASHMAP_UNIQUE_SUFFIX
 #undef HASHMAP_DATATYPE
+#undef HASHMAP_INLINE_KEY_SIZE
+#undef HASHMAP_KEYTYPE
+#undef HASHMAP_KEY_HASH
+#undef HASHMAP_KEY_EQ
+#undef HASHMAP_INTERN
+#undef HASHMAP_CONCURRENT
+#undef HASHMAP_SHARDED
+#undef HASHMAP_RCU
+#undef HASHMAP_PARALLEL_GROW
+#undef HASHMAP_AUTO_SHRINK
+#undef HASHMAP_HUGE_PAGES
+#undef HASHMAP_PREFAULT_THREADS
+#undef HASHMAP_HANDLE
 
 #undef HM_CONCAT0
 #undef HM_CONCAT
@@ -797,6 +4556,7 @@ char *HASHMAP_METHODNAME(tostr)(
 #undef HASHMAP_STRUCT_TAG
 #undef BUCKET_STRUCT_TAG
 #undef CELLAR_STRUCT_TAG
+#undef LINK_STRUCT_TAG
 
 #undef HASHMAP_METHODNAME
 #undef BUCKET_METHODNAME
@@ -9,10 +9,18 @@
 #include <stdbool.h> /* bool */
 #include <stdint.h>  /* fixed width types */
 
+#include "allocator/allocator.h"
 #include "compiler_attributes_macros.h"
 #include "len_type.h"
 #include "u8mem/u8mem.h"
 
+/* Type of the `key` parameters. */
+#ifdef HASHMAP_KEYTYPE
+#define KEY_TY HASHMAP_KEYTYPE
+#else
+#define KEY_TY u8mem
+#endif /* HASHMAP_KEYTYPE */
+
 #define COMMON_CALLBACKS_UNIQUE_SUFFIX HASHMAP_UNIQUE_SUFFIX
 #define COMMON_CALLBACKS_DATATYPE HASHMAP_DATATYPE
 #include "common_callback_types.h"
@@ -23,49 +31,232 @@
 #define HASHMAP_STRUCT_TAG HM_CONCAT(HashMap_, HASHMAP_UNIQUE_SUFFIX)
 #define BUCKET_STRUCT_TAG HM_CONCAT(Bucket_, HASHMAP_UNIQUE_SUFFIX)
 #define CELLAR_STRUCT_TAG HM_CONCAT(Cellar_, HASHMAP_UNIQUE_SUFFIX)
+#define LINK_STRUCT_TAG HM_CONCAT(Link_, HASHMAP_UNIQUE_SUFFIX)
+#define INTERNED_STRUCT_TAG HM_CONCAT(Interned_, HASHMAP_UNIQUE_SUFFIX)
+#define STRIPE_STRUCT_TAG HM_CONCAT(Stripe_, HASHMAP_UNIQUE_SUFFIX)
+#define CONCURRENT_STRUCT_TAG                                                  \
+  HM_CONCAT(ConcurrentHashMap_, HASHMAP_UNIQUE_SUFFIX)
+#define SHARDED_STRUCT_TAG HM_CONCAT(ShardedHashMap_, HASHMAP_UNIQUE_SUFFIX)
+#define READER_STRUCT_TAG HM_CONCAT(Reader_, HASHMAP_UNIQUE_SUFFIX)
+#define RCU_STRUCT_TAG HM_CONCAT(RcuHashMap_, HASHMAP_UNIQUE_SUFFIX)
+#define HANDLE_STRUCT_TAG HM_CONCAT(HashMapHandle_, HASHMAP_UNIQUE_SUFFIX)
 
 #define HASHMAP_METHODNAME(name)                                               \
   HM_CONCAT(HM_CONCAT(hm_, HASHMAP_UNIQUE_SUFFIX), HM_CONCAT(_, name))
 
 #ifndef DS_HASHMAP_HASHTYPE
-#define DS_HASHMAP_HASHTYPE
+#ifdef HASHMAP_64BIT_HASH
+#define DS_HASHMAP_HASHTYPE 64
+typedef uint64_t hash_ty;
+typedef uint64_t pos_ty;
+#else
+#define DS_HASHMAP_HASHTYPE 32
 typedef uint32_t hash_ty;
+typedef uint32_t pos_ty;
+#endif /* HASHMAP_64BIT_HASH */
 #endif /* DS_HASHMAP_HASHTYPE */
 
 typedef struct BUCKET_STRUCT_TAG BUCKET_STRUCT_TAG;
 typedef struct CELLAR_STRUCT_TAG CELLAR_STRUCT_TAG;
+typedef struct LINK_STRUCT_TAG LINK_STRUCT_TAG;
 typedef struct HASHMAP_STRUCT_TAG HASHMAP_STRUCT_TAG;
+#ifdef HASHMAP_INTERN
+typedef struct INTERNED_STRUCT_TAG INTERNED_STRUCT_TAG;
+#endif /* HASHMAP_INTERN */
+#if defined HASHMAP_CONCURRENT || defined HASHMAP_SHARDED
+typedef struct STRIPE_STRUCT_TAG STRIPE_STRUCT_TAG;
+#endif /* defined HASHMAP_CONCURRENT || defined HASHMAP_SHARDED */
+#ifdef HASHMAP_CONCURRENT
+typedef struct CONCURRENT_STRUCT_TAG CONCURRENT_STRUCT_TAG;
+#endif /* HASHMAP_CONCURRENT */
+#ifdef HASHMAP_SHARDED
+typedef struct SHARDED_STRUCT_TAG SHARDED_STRUCT_TAG;
+#endif /* HASHMAP_SHARDED */
+#ifdef HASHMAP_RCU
+typedef struct READER_STRUCT_TAG READER_STRUCT_TAG;
+typedef struct RCU_STRUCT_TAG RCU_STRUCT_TAG;
+#endif /* HASHMAP_RCU */
+#ifdef HASHMAP_HANDLE
+typedef struct HANDLE_STRUCT_TAG HANDLE_STRUCT_TAG;
+#endif /* HASHMAP_HANDLE */
 
 /* alloc */
 
 HASHMAP_STRUCT_TAG *HASHMAP_METHODNAME(new)(len_ty capacity);
+HASHMAP_STRUCT_TAG *HASHMAP_METHODNAME(new_seeded)(len_ty capacity,
+                                                   const uint64_t seed);
+HASHMAP_STRUCT_TAG *
+HASHMAP_METHODNAME(new_with_allocator)(len_ty capacity,
+                                       const allocator *const a);
 void *HASHMAP_METHODNAME(delete)(HASHMAP_STRUCT_TAG *const restrict hm,
                                  HM_CONCAT(free_mem_, HASHMAP_UNIQUE_SUFFIX) *
                                      data_free);
 HASHMAP_STRUCT_TAG *HASHMAP_METHODNAME(grow)(HASHMAP_STRUCT_TAG *const hm,
                                              const len_ty capacity);
+HASHMAP_STRUCT_TAG *HASHMAP_METHODNAME(shrink)(HASHMAP_STRUCT_TAG *const hm,
+                                               const len_ty capacity);
+HASHMAP_STRUCT_TAG *HASHMAP_METHODNAME(trim)(HASHMAP_STRUCT_TAG *const hm);
+#ifdef HASHMAP_PARALLEL_GROW
+HASHMAP_STRUCT_TAG *
+HASHMAP_METHODNAME(grow_parallel)(HASHMAP_STRUCT_TAG *const hm,
+                                  const len_ty capacity, unsigned int threads);
+HASHMAP_STRUCT_TAG *
+HASHMAP_METHODNAME(from_pairs)(const KEY_TY *const restrict keys,
+                               HASHMAP_DATATYPE const *const restrict values,
+                               const len_ty n, unsigned int threads);
+#endif /* HASHMAP_PARALLEL_GROW */
 HASHMAP_DATATYPE *
     HASHMAP_METHODNAME(insert)(HASHMAP_STRUCT_TAG *restrict *const hm,
-                               const u8mem key, HASHMAP_DATATYPE data);
+                               const KEY_TY key, HASHMAP_DATATYPE data);
+HASHMAP_DATATYPE *HASHMAP_METHODNAME(insert_hashed)(
+    HASHMAP_STRUCT_TAG *restrict *const hm, const hash_ty hash,
+    const KEY_TY key, HASHMAP_DATATYPE data);
+len_ty HASHMAP_METHODNAME(insert_batch)(
+    HASHMAP_STRUCT_TAG *restrict *const hm, const KEY_TY *const restrict keys,
+    HASHMAP_DATATYPE const *const restrict values, const len_ty n,
+    bool *const restrict added);
 HASHMAP_STRUCT_TAG *HASHMAP_METHODNAME(copy)(
     const HASHMAP_STRUCT_TAG *const restrict hm,
     HM_CONCAT(duplicate_, HASHMAP_UNIQUE_SUFFIX) data_dup,
     HM_CONCAT(free_mem_, HASHMAP_UNIQUE_SUFFIX) data_free);
 
-bool HASHMAP_METHODNAME(hash)(hash_ty *const dest, const u8mem key);
+bool HASHMAP_METHODNAME(hash)(const HASHMAP_STRUCT_TAG *const hm,
+                              hash_ty *const dest, const KEY_TY key);
 HASHMAP_DATATYPE *HASHMAP_METHODNAME(search)(HASHMAP_STRUCT_TAG *const hm,
-                                             const u8mem key);
+                                             const KEY_TY key);
+HASHMAP_DATATYPE *HASHMAP_METHODNAME(search_hashed)(
+    HASHMAP_STRUCT_TAG *const hm, const hash_ty hash, const KEY_TY key);
+bool HASHMAP_METHODNAME(search_batch)(HASHMAP_STRUCT_TAG *const hm,
+                                      const KEY_TY *const restrict keys,
+                                      const len_ty n,
+                                      HASHMAP_DATATYPE **const restrict out);
 bool HASHMAP_METHODNAME(remove)(HASHMAP_STRUCT_TAG *restrict hm,
                                 HASHMAP_DATATYPE *const restrict dest,
-                                const u8mem key);
+                                const KEY_TY key);
+bool HASHMAP_METHODNAME(remove_hashed)(HASHMAP_STRUCT_TAG *restrict hm,
+                                       HASHMAP_DATATYPE *const restrict dest,
+                                       const hash_ty hash, const KEY_TY key);
+
+#ifdef HASHMAP_INTERN
+const INTERNED_STRUCT_TAG *
+    HASHMAP_METHODNAME(intern)(HASHMAP_STRUCT_TAG *restrict *const hm,
+                               const u8mem key);
+HASHMAP_DATATYPE *HASHMAP_METHODNAME(search_interned)(
+    HASHMAP_STRUCT_TAG *const hm,
+    const INTERNED_STRUCT_TAG *const restrict handle);
+#endif /* HASHMAP_INTERN */
+
+#ifdef HASHMAP_CONCURRENT
+/* thread safe */
+
+CONCURRENT_STRUCT_TAG *
+HASHMAP_METHODNAME(concurrent_new)(const len_ty capacity, len_ty stripes);
+void *HASHMAP_METHODNAME(concurrent_delete)(
+    CONCURRENT_STRUCT_TAG *const restrict chm,
+    HM_CONCAT(free_mem_, HASHMAP_UNIQUE_SUFFIX) * data_free);
+bool HASHMAP_METHODNAME(concurrent_insert)(
+    CONCURRENT_STRUCT_TAG *const restrict chm, const KEY_TY key,
+    HASHMAP_DATATYPE data);
+bool HASHMAP_METHODNAME(concurrent_search)(
+    CONCURRENT_STRUCT_TAG *const restrict chm,
+    HASHMAP_DATATYPE *const restrict dest, const KEY_TY key);
+bool HASHMAP_METHODNAME(concurrent_remove)(
+    CONCURRENT_STRUCT_TAG *const restrict chm,
+    HASHMAP_DATATYPE *const restrict dest, const KEY_TY key);
+len_ty HASHMAP_METHODNAME(concurrent_used)(
+    CONCURRENT_STRUCT_TAG *const restrict chm);
+len_ty HASHMAP_METHODNAME(concurrent_capacity)(
+    CONCURRENT_STRUCT_TAG *const restrict chm);
+#endif /* HASHMAP_CONCURRENT */
+
+#ifdef HASHMAP_SHARDED
+/* thread safe, shards grow one at a time */
+
+SHARDED_STRUCT_TAG *HASHMAP_METHODNAME(sharded_new)(const len_ty capacity,
+                                                    const unsigned int bits);
+void *HASHMAP_METHODNAME(sharded_delete)(
+    SHARDED_STRUCT_TAG *const restrict shm,
+    HM_CONCAT(free_mem_, HASHMAP_UNIQUE_SUFFIX) * data_free);
+bool HASHMAP_METHODNAME(sharded_insert)(SHARDED_STRUCT_TAG *const restrict shm,
+                                        const KEY_TY key,
+                                        HASHMAP_DATATYPE data);
+bool HASHMAP_METHODNAME(sharded_search)(SHARDED_STRUCT_TAG *const restrict shm,
+                                        HASHMAP_DATATYPE *const restrict dest,
+                                        const KEY_TY key);
+bool HASHMAP_METHODNAME(sharded_remove)(SHARDED_STRUCT_TAG *const restrict shm,
+                                        HASHMAP_DATATYPE *const restrict dest,
+                                        const KEY_TY key);
+len_ty
+HASHMAP_METHODNAME(sharded_used)(SHARDED_STRUCT_TAG *const restrict shm);
+len_ty
+HASHMAP_METHODNAME(sharded_capacity)(SHARDED_STRUCT_TAG *const restrict shm);
+#endif /* HASHMAP_SHARDED */
+
+#ifdef HASHMAP_RCU
+/* lock free reads */
+
+RCU_STRUCT_TAG *HASHMAP_METHODNAME(rcu_new)(const len_ty capacity);
+void *HASHMAP_METHODNAME(rcu_delete)(
+    RCU_STRUCT_TAG *const restrict rmh,
+    HM_CONCAT(free_mem_, HASHMAP_UNIQUE_SUFFIX) * data_free);
+bool HASHMAP_METHODNAME(rcu_insert)(RCU_STRUCT_TAG *const restrict rmh,
+                                    const KEY_TY key, HASHMAP_DATATYPE data);
+bool HASHMAP_METHODNAME(rcu_search)(RCU_STRUCT_TAG *const restrict rmh,
+                                    HASHMAP_DATATYPE *const restrict dest,
+                                    const KEY_TY key);
+bool HASHMAP_METHODNAME(rcu_remove)(RCU_STRUCT_TAG *const restrict rmh,
+                                    HASHMAP_DATATYPE *const restrict dest,
+                                    const KEY_TY key);
+bool HASHMAP_METHODNAME(rcu_grow)(RCU_STRUCT_TAG *const restrict rmh,
+                                  const len_ty capacity);
+#endif /* HASHMAP_RCU */
+
+#ifdef HASHMAP_HANDLE
+/* stable address */
+
+HANDLE_STRUCT_TAG *HASHMAP_METHODNAME(handle_new)(const len_ty capacity);
+void *HASHMAP_METHODNAME(handle_delete)(
+    HANDLE_STRUCT_TAG *const restrict hmh,
+    HM_CONCAT(free_mem_, HASHMAP_UNIQUE_SUFFIX) * data_free);
+HASHMAP_DATATYPE *
+    HASHMAP_METHODNAME(handle_insert)(HANDLE_STRUCT_TAG *const restrict hmh,
+                                      const KEY_TY key, HASHMAP_DATATYPE data);
+HASHMAP_DATATYPE *
+    HASHMAP_METHODNAME(handle_search)(HANDLE_STRUCT_TAG *const restrict hmh,
+                                      const KEY_TY key);
+bool HASHMAP_METHODNAME(handle_remove)(HANDLE_STRUCT_TAG *const restrict hmh,
+                                       HASHMAP_DATATYPE *const restrict dest,
+                                       const KEY_TY key);
+bool HASHMAP_METHODNAME(handle_grow)(HANDLE_STRUCT_TAG *const restrict hmh,
+                                     const len_ty capacity);
+bool HASHMAP_METHODNAME(handle_shrink)(HANDLE_STRUCT_TAG *const restrict hmh,
+                                       const len_ty capacity);
+HASHMAP_STRUCT_TAG *
+HASHMAP_METHODNAME(handle_map)(const HANDLE_STRUCT_TAG *const restrict hmh);
+#endif /* HASHMAP_HANDLE */
 
 char *HASHMAP_METHODNAME(tostr)(const HASHMAP_STRUCT_TAG *const restrict hm,
                                 HM_CONCAT(stringify_data_,
                                           HASHMAP_UNIQUE_SUFFIX) *
                                     data_tostr);
+bool HASHMAP_METHODNAME(memory_usage)(
+    const HASHMAP_STRUCT_TAG *const restrict hm,
+    hm_memory *const restrict dest);
 
 #undef HASHMAP_UNIQUE_SUFFIX
 #undef HASHMAP_DATATYPE
+#undef HASHMAP_INLINE_KEY_SIZE
+#undef HASHMAP_KEYTYPE
+#undef HASHMAP_INTERN
+#undef HASHMAP_CONCURRENT
+#undef HASHMAP_SHARDED
+#undef HASHMAP_RCU
+#undef HASHMAP_PARALLEL_GROW
+#undef HASHMAP_AUTO_SHRINK
+#undef HASHMAP_HUGE_PAGES
+#undef HASHMAP_PREFAULT_THREADS
+#undef HASHMAP_HANDLE
+#undef KEY_TY
 
 #undef HM_CONCAT0
 #undef HM_CONCAT
@@ -73,5 +264,13 @@ char *HASHMAP_METHODNAME(tostr)(const HASHMAP_STRUCT_TAG *const restrict hm,
 #undef HASHMAP_STRUCT_TAG
 #undef BUCKET_STRUCT_TAG
 #undef CELLAR_STRUCT_TAG
+#undef LINK_STRUCT_TAG
+#undef INTERNED_STRUCT_TAG
+#undef STRIPE_STRUCT_TAG
+#undef CONCURRENT_STRUCT_TAG
+#undef SHARDED_STRUCT_TAG
+#undef READER_STRUCT_TAG
+#undef RCU_STRUCT_TAG
+#undef HANDLE_STRUCT_TAG
 
 #undef HASHMAP_METHODNAME
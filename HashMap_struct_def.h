@@ -6,23 +6,181 @@
 #error "Missing definition for `HASHMAP_DATATYPE`."
 #endif /* HASHMAP_DATATYPE */
 
+/* Optional: keys up to `HASHMAP_INLINE_KEY_SIZE` bytes are stored in the */
+/* Buckets instead of on the heap. */
+#if defined HASHMAP_INLINE_KEY_SIZE && HASHMAP_INLINE_KEY_SIZE < 1
+#error "`HASHMAP_INLINE_KEY_SIZE` should be greater than 0."
+#endif /* defined HASHMAP_INLINE_KEY_SIZE && HASHMAP_INLINE_KEY_SIZE < 1 */
+
+/* Optional: keys of type `HASHMAP_KEYTYPE` are stored in the Buckets */
+/* instead of `u8mem` blocks. */
+#if defined HASHMAP_KEYTYPE && defined HASHMAP_INLINE_KEY_SIZE
+#error "`HASHMAP_KEYTYPE` keys are always stored in the Buckets."
+#endif /* defined HASHMAP_KEYTYPE && defined HASHMAP_INLINE_KEY_SIZE */
+
+/* Optional: every key is interned, the Buckets point to canonical copies */
+/* that callers can hold on to as handles. */
+#if defined HASHMAP_INTERN &&                                                  \
+    (defined HASHMAP_KEYTYPE || defined HASHMAP_INLINE_KEY_SIZE)
+#error "`HASHMAP_INTERN` handles are heap allocated `u8mem` keys."
+#endif
+
 #include <stdbool.h> /* bool */
 #include <stdint.h>  /* fixed width types */
 
+#include "allocator/allocator.h"
 #include "len_type.h"
 #include "u8mem/u8mem.h"
 
+// #define HASHMAP_CONCURRENT
+// #define HASHMAP_SHARDED
+
+#if defined HASHMAP_CONCURRENT || defined HASHMAP_SHARDED
+#ifdef __STDC_NO_THREADS__
+#error "`HASHMAP_CONCURRENT` and `HASHMAP_SHARDED` need C11 threads."
+#endif /* __STDC_NO_THREADS__ */
+
+#include <threads.h> /* mtx_t */
+#endif /* defined HASHMAP_CONCURRENT || defined HASHMAP_SHARDED */
+
+// #define HASHMAP_RCU
+
+#ifdef HASHMAP_RCU
+#if defined __STDC_NO_THREADS__ || defined __STDC_NO_ATOMICS__
+#error "`HASHMAP_RCU` needs C11 threads and atomics."
+#endif /* defined __STDC_NO_THREADS__ || defined __STDC_NO_ATOMICS__ */
+
+#include <stdatomic.h> /* atomic types */
+#include <threads.h>   /* mtx_t */
+#endif /* HASHMAP_RCU */
+
+// #define HASHMAP_PARALLEL_GROW
+
+#if defined HASHMAP_PARALLEL_GROW && defined __STDC_NO_THREADS__
+#error "`HASHMAP_PARALLEL_GROW` needs C11 threads."
+#endif /* defined HASHMAP_PARALLEL_GROW && defined __STDC_NO_THREADS__ */
+
+/* Optional: a HashMapHandle whose address stays the same while the */
+/* HashMap behind it is replaced by resizes. */
+// #define HASHMAP_HANDLE
+
+/* Optional: the shards of a ShardedHashMap and the maps of an RcuHashMap */
+/* and of a HashMapHandle are trimmed after removals. */
+// #define HASHMAP_AUTO_SHRINK
+
+/* Optional: HashMaps without an allocator whose Buckets take at least */
+/* `HASHMAP_HUGE_PAGES_THRESHOLD` bytes are mapped from the kernel and */
+/* backed by huge pages, so random probes miss the TLB less often. */
+// #define HASHMAP_HUGE_PAGES
+
+/* Optional: number of threads that fault in the pages of such a HashMap */
+/* when it is created, instead of its first probes. */
+// #define HASHMAP_PREFAULT_THREADS 4
+
+#if defined HASHMAP_PREFAULT_THREADS && !defined HASHMAP_HUGE_PAGES
+#error "`HASHMAP_PREFAULT_THREADS` needs `HASHMAP_HUGE_PAGES`."
+#endif /* defined HASHMAP_PREFAULT_THREADS && !defined HASHMAP_HUGE_PAGES */
+
 #define HM_CONCAT0(tok0, tok1) tok0##tok1
 #define HM_CONCAT(tok0, tok1) HM_CONCAT0(tok0, tok1)
 
 #define HASHMAP_STRUCT_TAG HM_CONCAT(HashMap_, HASHMAP_UNIQUE_SUFFIX)
 #define BUCKET_STRUCT_TAG HM_CONCAT(Bucket_, HASHMAP_UNIQUE_SUFFIX)
+#define LINK_STRUCT_TAG HM_CONCAT(Link_, HASHMAP_UNIQUE_SUFFIX)
+#define INTERNED_STRUCT_TAG HM_CONCAT(Interned_, HASHMAP_UNIQUE_SUFFIX)
+#define STRIPE_STRUCT_TAG HM_CONCAT(Stripe_, HASHMAP_UNIQUE_SUFFIX)
+#define CONCURRENT_STRUCT_TAG                                                  \
+  HM_CONCAT(ConcurrentHashMap_, HASHMAP_UNIQUE_SUFFIX)
+#define SHARDED_STRUCT_TAG HM_CONCAT(ShardedHashMap_, HASHMAP_UNIQUE_SUFFIX)
+#define READER_STRUCT_TAG HM_CONCAT(Reader_, HASHMAP_UNIQUE_SUFFIX)
+#define RCU_STRUCT_TAG HM_CONCAT(RcuHashMap_, HASHMAP_UNIQUE_SUFFIX)
+#define HANDLE_STRUCT_TAG HM_CONCAT(HashMapHandle_, HASHMAP_UNIQUE_SUFFIX)
+
+// #define HASHMAP_64BIT_HASH
 
 #ifndef DS_HASHMAP_HASHTYPE
-#define DS_HASHMAP_HASHTYPE
+#ifdef HASHMAP_64BIT_HASH
+#define DS_HASHMAP_HASHTYPE 64
+/*! @brief type of the hash of a key. */
+typedef uint64_t hash_ty;
+/*! @brief type of the 1-based position of a Bucket in a collision chain. */
+typedef uint64_t pos_ty;
+#else
+#define DS_HASHMAP_HASHTYPE 32
+/*! @brief type of the hash of a key. */
 typedef uint32_t hash_ty;
+/*! @brief type of the 1-based position of a Bucket in a collision chain. */
+typedef uint32_t pos_ty;
+#endif /* HASHMAP_64BIT_HASH */
 #endif /* DS_HASHMAP_HASHTYPE */
 
+#if defined HASHMAP_64BIT_HASH != (DS_HASHMAP_HASHTYPE == 64)
+#error "All HashMaps in a translation unit must use the same `hash_ty`."
+#endif
+
+#ifndef DS_HASHMAP_MEMORY
+#define DS_HASHMAP_MEMORY
+/*!
+ * @brief bytes of memory used by a HashMap, by what they are used for.
+ */
+typedef struct hm_memory {
+  /*! @public the HashMap, its Buckets and the arrays stored after them. */
+  size_t table;
+  /*! @public the Buckets of the cellar. */
+  size_t cellar;
+  /*! @public keys stored outside the Buckets. */
+  size_t keys;
+  /*! @public estimate of what the allocator adds to each block. */
+  size_t overhead;
+  /*! @public sum of the above. */
+  size_t total;
+  /*! @public `total` divided by the number of keys, 0 without keys. */
+  double per_key;
+} hm_memory;
+#endif /* DS_HASHMAP_MEMORY */
+
+// #define SWISS_TABLE_PROBING
+
+#if defined SWISS_TABLE_PROBING &&                                             \
+    (defined CELLAR_COALESCED_HASHING || defined EMPTY_BUCKET_STACK)
+#error "`SWISS_TABLE_PROBING` does not use collision chains."
+#endif
+
+// #define ROBIN_HOOD_HASHING
+
+#if defined ROBIN_HOOD_HASHING &&                                              \
+    (defined CELLAR_COALESCED_HASHING || defined EMPTY_BUCKET_STACK ||         \
+     defined SWISS_TABLE_PROBING)
+#error "`ROBIN_HOOD_HASHING` does not use collision chains."
+#endif
+
+// #define HOT_COLD_SPLIT
+
+#if defined HOT_COLD_SPLIT && defined SWISS_TABLE_PROBING
+#error "`SWISS_TABLE_PROBING` already keeps its probing data out of the Buckets."
+#endif
+
+#if defined HOT_COLD_SPLIT && defined ROBIN_HOOD_HASHING
+#error "`ROBIN_HOOD_HASHING` does not use collision chains."
+#endif
+
+#ifdef HASHMAP_INTERN
+/*!
+ * @brief canonical copy of a key in an interning HashMap.
+ *
+ * Its address does not change until the key is removed or the HashMap is
+ * deleted, so equal keys can be compared by address.
+ */
+struct INTERNED_STRUCT_TAG {
+  /*! @public the key, `key.buf` points to `bytes`. */
+  u8mem key;
+  /*! @protected the hash of the key under the seed of the HashMap. */
+  hash_ty hash;
+  /*! @protected the bytes of the key. */
+  unsigned char bytes[];
+};
+#endif /* HASHMAP_INTERN */
+
 /*!
  * @brief type that holds details of a HashMap entry.
  */
@@ -31,13 +189,52 @@ struct BUCKET_STRUCT_TAG {
   HASHMAP_DATATYPE data;
   /*! @protected the hash of the key. */
   hash_ty hash;
+#if defined HASHMAP_KEYTYPE
+  /*! @protected unique key of the entry. */
+  HASHMAP_KEYTYPE key;
+  /*! @protected true if the Bucket is in use. */
+  bool live;
+#elif defined HASHMAP_INLINE_KEY_SIZE
+  /*! @protected unique key of the entry. */
+  union {
+    /*! @protected keys not longer than `HASHMAP_INLINE_KEY_SIZE`. */
+    unsigned char buf[HASHMAP_INLINE_KEY_SIZE];
+    /*! @protected longer keys. */
+    u8mem *restrict mem;
+  } key;
+  /*! @protected length of the key, 0 if the Bucket is unused. */
+  len_ty key_len;
+#elif defined HASHMAP_INTERN
+  /*! @protected unique key of the entry. */
+  struct INTERNED_STRUCT_TAG *restrict key;
+#else
   /*! @protected unique key of the entry. */
   u8mem *restrict key;
+#endif /* defined HASHMAP_KEYTYPE */
+#if !defined SWISS_TABLE_PROBING && !defined ROBIN_HOOD_HASHING
   /*! @protected position to the previous colliding Bucket. */
-  unsigned int prev_pos;
+  pos_ty prev_pos;
+#ifndef HOT_COLD_SPLIT
+  /*! @protected position to the next colliding Bucket. */
+  pos_ty next_pos;
+#endif /* HOT_COLD_SPLIT */
+#endif /* !defined SWISS_TABLE_PROBING && !defined ROBIN_HOOD_HASHING */
+};
+
+#ifdef HOT_COLD_SPLIT
+/*!
+ * @brief the fields of a Bucket read while walking a collision chain.
+ *
+ * Links are kept in a dense array after the Buckets, one per Bucket, so a
+ * chain walk only reads the Bucket itself once the hashes match.
+ */
+struct LINK_STRUCT_TAG {
+  /*! @protected the hash of the key. */
+  hash_ty hash;
   /*! @protected position to the next colliding Bucket. */
-  unsigned int next_pos;
+  pos_ty next_pos;
 };
+#endif /* HOT_COLD_SPLIT */
 
 // #define CELLAR_COALESCED_HASHING
 
@@ -59,6 +256,12 @@ struct CELLAR_STRUCT_TAG {
 
 // #define EMPTY_BUCKET_STACK
 
+#if defined HOT_COLD_SPLIT && defined EMPTY_BUCKET_STACK
+#error "`HOT_COLD_SPLIT` needs unused Buckets to have zeroed links."
+#endif
+
+// #define INCREMENTAL_RESIZE
+
 /*!
  * @brief a hash table type.
  */
@@ -67,26 +270,224 @@ struct HASHMAP_STRUCT_TAG {
   len_ty capacity;
   /*! @public  number of used Buckets. */
   len_ty used;
+  /*! @public seed of the hash function, random for each HashMap unless */
+  /*! given to `new_seeded`. Read only, hashes computed before it changes are */
+  /*! stale. */
+  uint64_t seed;
+  /*! @protected set when a search walks more than `HASHMAP_RESEED_CHAIN` */
+  /*! Buckets. */
+#ifdef HASHMAP_RCU
+  /*! Searches set it while other threads read the HashMap. */
+  atomic_bool long_chain;
+#else
+  bool long_chain;
+#endif /* HASHMAP_RCU */
+  /*! @protected set when the HashMap has been rehashed with a fresh seed */
+  /*! since it last grew. */
+  bool reseeded;
 #ifdef CELLAR_COALESCED_HASHING
   /*! @protected cellar for handling colliding buckets. */
   struct CELLAR_STRUCT_TAG cellar;
 #endif /* CELLAR_COALESCED_HASHING */
 #ifdef EMPTY_BUCKET_STACK
   /*! @protected position of the bucket at the top of the stack. */
-  unsigned int top_pos;
+  pos_ty top_pos;
 #endif /* EMPTY_BUCKET_STACK */
+#if !defined SWISS_TABLE_PROBING && !defined ROBIN_HOOD_HASHING &&            \
+    !defined EMPTY_BUCKET_STACK
+  /*! @protected word of the occupancy bitmap to start looking for an */
+  /*! unused Bucket from. */
+  len_ty free_hint;
+#endif
+#ifdef SWISS_TABLE_PROBING
+  /*! @protected number of Buckets marked as deleted in the control bytes. */
+  len_ty deleted;
+#endif /* SWISS_TABLE_PROBING */
+  /*! @protected bytes allocated for keys stored outside the Buckets. */
+  len_ty key_bytes;
+  /*! @protected number of blocks allocated for keys. */
+  len_ty key_blocks;
+  /*! @protected where the Buckets and keys are allocated, NULL for */
+  /*! `xmalloc`. */
+  const allocator *alloc;
+#ifdef INCREMENTAL_RESIZE
+  /*! @protected HashMap whose Buckets are being moved into this one. */
+  struct HASHMAP_STRUCT_TAG *restrict old;
+  /*! @protected number of slots in `old` that are yet to be emptied. */
+  len_ty old_pos;
+#endif /* INCREMENTAL_RESIZE */
   /*! @protected array of Buckets. */
   struct BUCKET_STRUCT_TAG arr[];
 };
 
 #define HASHMAP_MAX_LOAD_FACTOR 0.95
+/*! load factor under which `trim` shrinks a HashMap. */
+#define HASHMAP_MIN_LOAD_FACTOR 0.2
+/*! load factor `trim` shrinks a HashMap to. It is far from both limits, so */
+/*! a few inserts or removes after a resize do not resize it again. */
+#define HASHMAP_SHRINK_LOAD_FACTOR 0.5
+/*! capacity up to which `trim` leaves a HashMap alone. */
+#define HASHMAP_MIN_TRIM_CAPACITY 64
+/*! number of old slots emptied per operation during a resize. */
+#define HASHMAP_MIGRATE_STEP 8
+/*! number of keys hashed and prefetched together by `search_batch`. */
+#define HASHMAP_BATCH_GROUP 16
+/*! length of a walk that makes the next insertion change the seed. */
+#define HASHMAP_RESEED_CHAIN 128
+
+/*! bytes a typical allocator adds to each block for its header and */
+/*! alignment, used to estimate the memory used by a HashMap. */
+#define HASHMAP_ALLOC_OVERHEAD 16
+
+/*! size of the cache lines that shared counters and locks are aligned to. */
+#define HASHMAP_CACHE_LINE 64
+
+#ifdef HASHMAP_HUGE_PAGES
+/*! size from which the block a HashMap is stored in is mapped with huge */
+/*! pages. Smaller blocks would waste most of a huge page. */
+#define HASHMAP_HUGE_PAGES_THRESHOLD ((size_t)32 << 20)
+#endif /* HASHMAP_HUGE_PAGES */
+
+#ifdef HASHMAP_PARALLEL_GROW
+/*! maximum number of threads moving the Buckets of one HashMap. */
+#define HASHMAP_MAX_GROW_THREADS 64
+/*! minimum number of slots worth handing to another thread when growing. */
+#define HASHMAP_GROW_THREAD_SLOTS 4096
+/*! number of ranges of the new slots that the moved Buckets are sorted by. */
+#define HASHMAP_GROW_REGIONS 256
+#endif /* HASHMAP_PARALLEL_GROW */
+
+#if defined HASHMAP_CONCURRENT || defined HASHMAP_SHARDED
+/*!
+ * @brief a lock and the HashMap it guards.
+ */
+struct STRIPE_STRUCT_TAG {
+  /*! @protected held while `map` is in use. */
+  _Alignas(HASHMAP_CACHE_LINE) mtx_t lock;
+  /*! @protected the keys whose hashes select this stripe. */
+  struct HASHMAP_STRUCT_TAG *restrict map;
+};
+#endif /* defined HASHMAP_CONCURRENT || defined HASHMAP_SHARDED */
+
+#ifdef HASHMAP_CONCURRENT
+/*! maximum number of stripes in a concurrent HashMap. */
+#define HASHMAP_MAX_STRIPES 4096
+
+/*!
+ * @brief a hash table type that can be used from several threads at once.
+ *
+ * The keys are split across stripes by their hashes. Operations on keys in
+ * different stripes do not wait for each other. A new key that fills its
+ * stripe doubles every stripe at once, so that they keep the same capacity.
+ * A stripe may still be rehashed alone at its capacity, to reseed it or to
+ * clear its deleted slots.
+ */
+struct CONCURRENT_STRUCT_TAG {
+  /*! @public number of stripes, a power of 2. */
+  len_ty stripe_count;
+  /*! @protected number of hash bits that select a stripe. */
+  unsigned int stripe_bits;
+  /*! @protected seed of the hash function, shared by the stripes. */
+  uint64_t seed;
+  /*! @protected the stripes. */
+  struct STRIPE_STRUCT_TAG *restrict stripes;
+};
+#endif /* HASHMAP_CONCURRENT */
+
+#ifdef HASHMAP_SHARDED
+/*! maximum number of hash bits that select a shard. */
+#define HASHMAP_MAX_SHARD_BITS 12
+
+/*!
+ * @brief a hash table type split into HashMaps that grow on their own.
+ *
+ * The top bits of the hashes of the keys select a shard. Every shard has its
+ * own lock and grows when it fills up without waiting for the others, so a
+ * resize only moves the keys of one shard.
+ */
+struct SHARDED_STRUCT_TAG {
+  /*! @public number of shards, 2 to the power of `shard_bits`. */
+  len_ty shard_count;
+  /*! @public number of hash bits that select a shard. */
+  unsigned int shard_bits;
+  /*! @protected seed of the hash function that selects the shards. */
+  uint64_t seed;
+  /*! @protected the shards. */
+  struct STRIPE_STRUCT_TAG *restrict shards;
+};
+#endif /* HASHMAP_SHARDED */
+
+#ifdef HASHMAP_RCU
+/*! number of slots readers of an RCU HashMap are spread over. */
+#define HASHMAP_READER_SLOTS 64
+
+/*!
+ * @brief the readers of an RCU HashMap that share a slot.
+ */
+struct READER_STRUCT_TAG {
+  /*! @protected number of readers that started in an even or odd epoch. */
+  _Alignas(HASHMAP_CACHE_LINE) atomic_uint_fast32_t active[2];
+};
+
+/*!
+ * @brief a hash table type whose searches take no locks.
+ *
+ * Writers copy the published HashMap, modify the copy and publish it in its
+ * place. The replaced HashMap is deleted once every reader that could have
+ * seen it has finished, so writes cost a copy of the whole HashMap and suit
+ * HashMaps that are read far more often than they are written.
+ */
+struct RCU_STRUCT_TAG {
+  /*! @protected the published HashMap, only searches may use it. */
+  _Atomic(struct HASHMAP_STRUCT_TAG *) map;
+  /*! @protected incremented every time a HashMap is replaced. */
+  atomic_uint_fast64_t epoch;
+  /*! @protected held by writers. */
+  mtx_t write_lock;
+  /*! @protected the readers, on separate cache lines. */
+  struct READER_STRUCT_TAG readers[HASHMAP_READER_SLOTS];
+};
+#endif /* HASHMAP_RCU */
+
+#ifdef HASHMAP_HANDLE
+/*!
+ * @brief a HashMap behind an address that does not change.
+ *
+ * Resizes replace the HashMap but not the handle, so parts of a program can
+ * share a handle without passing the new HashMap around after every insert.
+ * A handle is no more thread safe than a HashMap.
+ */
+struct HANDLE_STRUCT_TAG {
+  /*! @protected the HashMap, replaced when it resizes. */
+  struct HASHMAP_STRUCT_TAG *restrict map;
+};
+#endif /* HASHMAP_HANDLE */
 
 #undef HASHMAP_UNIQUE_SUFFIX
 #undef HASHMAP_DATATYPE
+#undef HASHMAP_INLINE_KEY_SIZE
+#undef HASHMAP_KEYTYPE
+#undef HASHMAP_INTERN
+#undef HASHMAP_CONCURRENT
+#undef HASHMAP_SHARDED
+#undef HASHMAP_RCU
+#undef HASHMAP_PARALLEL_GROW
+#undef HASHMAP_AUTO_SHRINK
+#undef HASHMAP_HUGE_PAGES
+#undef HASHMAP_PREFAULT_THREADS
+#undef HASHMAP_HANDLE
 
 #undef HM_CONCAT0
 #undef HM_CONCAT
 
 #undef HASHMAP_STRUCT_TAG
 #undef BUCKET_STRUCT_TAG
+#undef LINK_STRUCT_TAG
 #undef CELLAR_STRUCT_TAG
+#undef INTERNED_STRUCT_TAG
+#undef STRIPE_STRUCT_TAG
+#undef CONCURRENT_STRUCT_TAG
+#undef SHARDED_STRUCT_TAG
+#undef READER_STRUCT_TAG
+#undef RCU_STRUCT_TAG
+#undef HANDLE_STRUCT_TAG
@@ -1,5 +1,5 @@
-#ifndef MURMURHASH3_X86_32_HASH
-#define MURMURHASH3_X86_32_HASH
+#ifndef MURMURHASH3_HASH
+#define MURMURHASH3_HASH
 
 // murmurhash3 was written by Austin Appleby, and is placed in the public
 // domain. The author hereby disclaims copyright to this source code.
@@ -21,6 +21,8 @@
 	#define FORCE_INLINE inline
 #endif
 
+#ifdef MURMURHASH3_x86_32_HASH_FUNC
+
 static FORCE_INLINE uint32_t rotl32(uint32_t x, int8_t r)
 {
 	return (x << r) | (x >> (32 - r));
@@ -96,6 +98,122 @@ static void murmurhash3_x86_32(
 	*dest = hash;
 }
 
+#endif /* MURMURHASH3_x86_32_HASH_FUNC */
+
+#ifdef MURMURHASH3_x64_128_HASH_FUNC
+
+static FORCE_INLINE uint64_t rotl64(uint64_t x, int8_t r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+/*!
+ * @brief Read 8 bytes from pointer.
+ *
+ * If your platform needs to do endian-swapping or can only handle aligned reads,
+ * do the conversion here.
+ */
+FORCE_INLINE uint64_t getblock64(const uint8_t *const restrict p)
+{
+	uint64_t d;
+	memcpy(&d, p, sizeof(d));
+	return d;
+}
+
+/*! @brief Finalization mix - force all bits of a hash block to avalanche. */
+static FORCE_INLINE uint64_t fmix64(uint64_t k)
+{
+	k ^= k >> 33;
+	k *= 0xff51afd7ed558ccdULL;
+	k ^= k >> 33;
+	k *= 0xc4ceb9fe1a85ec53ULL;
+	k ^= k >> 33;
+
+	return k;
+}
+
+static void murmurhash3_x64_128(
+	const unsigned char *const restrict key, const size_t len,
+	void *const restrict out
+) _nonnull;
+
+/*!
+ * @brief 128 bit MurmurHash3 optimised for 64 bit platforms.
+ *
+ * @param key start of buffer to hash.
+ * @param len length of buffer in octets.
+ * @param out pointer to 2 `uint64_t`, the first initialised to the seed.
+ */
+static void murmurhash3_x64_128(
+	const unsigned char *const restrict key, const size_t len,
+	void *const restrict out
+)
+{
+	uint64_t *const restrict dest = out;
+	const size_t nblocks = len / 16;
+	const uint64_t c1 = 0x87c37b91114253d5ULL, c2 = 0x4cf5ad432745937fULL;
+	uint64_t h1 = dest[0], h2 = dest[0];
+
+	for (size_t i = 0; i < nblocks; i++)
+	{
+		uint64_t k1 = getblock64(&key[i * 16]);
+		uint64_t k2 = getblock64(&key[i * 16 + 8]);
+
+		k1 = rotl64(k1 * c1, 31) * c2;
+		h1 = rotl64(h1 ^ k1, 27) + h2;
+		h1 = h1 * 5 + 0x52dce729;
+
+		k2 = rotl64(k2 * c2, 33) * c1;
+		h2 = rotl64(h2 ^ k2, 31) + h1;
+		h2 = h2 * 5 + 0x38495ab5;
+	}
+
+	const uint8_t *const tail = key + nblocks * 16;
+	uint64_t k1 = 0, k2 = 0;
+
+	switch (len & 15)
+	{
+		/* clang-format off */
+	case 15: k2 ^= (uint64_t)tail[14] << 48; /* fallthrough */
+	case 14: k2 ^= (uint64_t)tail[13] << 40; /* fallthrough */
+	case 13: k2 ^= (uint64_t)tail[12] << 32; /* fallthrough */
+	case 12: k2 ^= (uint64_t)tail[11] << 24; /* fallthrough */
+	case 11: k2 ^= (uint64_t)tail[10] << 16; /* fallthrough */
+	case 10: k2 ^= (uint64_t)tail[9] << 8; /* fallthrough */
+	case 9: k2 ^= (uint64_t)tail[8] << 0;
+		/* clang-format on */
+		k2 = rotl64(k2 * c2, 33) * c1;
+		h2 ^= k2;
+		/* fallthrough */
+		/* clang-format off */
+	case 8: k1 ^= (uint64_t)tail[7] << 56; /* fallthrough */
+	case 7: k1 ^= (uint64_t)tail[6] << 48; /* fallthrough */
+	case 6: k1 ^= (uint64_t)tail[5] << 40; /* fallthrough */
+	case 5: k1 ^= (uint64_t)tail[4] << 32; /* fallthrough */
+	case 4: k1 ^= (uint64_t)tail[3] << 24; /* fallthrough */
+	case 3: k1 ^= (uint64_t)tail[2] << 16; /* fallthrough */
+	case 2: k1 ^= (uint64_t)tail[1] << 8; /* fallthrough */
+	case 1: k1 ^= (uint64_t)tail[0] << 0;
+		/* clang-format on */
+		k1 = rotl64(k1 * c1, 31) * c2;
+		h1 ^= k1;
+	};
+
+	h1 ^= len;
+	h2 ^= len;
+	h1 += h2;
+	h2 += h1;
+	h1 = fmix64(h1);
+	h2 = fmix64(h2);
+	h1 += h2;
+	h2 += h1;
+
+	dest[0] = h1;
+	dest[1] = h2;
+}
+
+#endif /* MURMURHASH3_x64_128_HASH_FUNC */
+
 #undef FORCE_INLINE
 
-#endif  // MURMURHASH3_X86_32_HASH
+#endif  // MURMURHASH3_HASH
@@ -0,0 +1,130 @@
+#ifndef AES_ROUND_HASH
+#define AES_ROUND_HASH
+
+/*
+ * Hash built on the AES-NI round instruction.
+ *
+ * Four 128 bit lanes each absorb a 16 byte block per AES round, so 64 bytes
+ * are consumed per iteration. The lanes are then folded together and
+ * finished with a few more rounds keyed with the seed and the length. This
+ * is not a cryptographic hash, the rounds are only used as a fast and
+ * well diffusing mixing function.
+ */
+
+#if (defined __x86_64__ || defined _M_X64) && defined __GNUC__
+	#define AES_ROUND_HASH_SUPPORTED
+
+	#include "compiler_attributes_macros.h"
+
+	#include <immintrin.h>
+	#include <stddef.h> /* size_t */
+	#include <stdint.h> /* uint32_t, uint64_t */
+	#include <string.h> /* memcpy */
+
+	#define AES_HASH_TARGET __attribute__((target("aes,sse2")))
+
+static void aes_hash(
+	const unsigned char *const restrict key, const size_t len,
+	void *const restrict out
+) _nonnull AES_HASH_TARGET;
+
+/*! @brief load 16 unaligned bytes. */
+static inline AES_HASH_TARGET __m128i aes_load(const unsigned char *const p)
+{
+	return (_mm_loadu_si128((const __m128i *)p));
+}
+
+/*! @brief digits of pi that keep the lanes apart. */
+static const uint64_t aes_hash_lanes[8] = {
+	0x243f6a8885a308d3ULL, 0x13198a2e03707344ULL, 0xa4093822299f31d0ULL,
+	0x082efa98ec4e6c89ULL, 0x452821e638d01377ULL, 0xbe5466cf34e90c6cULL,
+	0xc0ac29b7c97c50ddULL, 0x3f84d5b5b5470917ULL,
+};
+
+/*! @brief initial value of lane `i`. */
+static inline AES_HASH_TARGET __m128i aes_lane(const unsigned int i)
+{
+	return (_mm_loadu_si128((const __m128i *)&aes_hash_lanes[i * 2]));
+}
+
+/*!
+ * @brief 64 bit hash of a buffer using AES rounds.
+ *
+ * Only call this after checking that the CPU supports AES-NI.
+ *
+ * @param key start of buffer to hash.
+ * @param len length of buffer in octets.
+ * @param out pointer to a `uint64_t` initialised to the seed.
+ */
+static void aes_hash(
+	const unsigned char *const restrict key, const size_t len,
+	void *const restrict out
+)
+{
+	uint64_t *const restrict dest = out;
+	const __m128i seed = _mm_set_epi64x((long long)len, (long long)*dest);
+	__m128i s0 = _mm_xor_si128(seed, aes_lane(0));
+	__m128i s1 = _mm_xor_si128(seed, aes_lane(1));
+	__m128i s2 = _mm_xor_si128(seed, aes_lane(2));
+	__m128i s3 = _mm_xor_si128(seed, aes_lane(3));
+	const unsigned char *p = key;
+	size_t n = len;
+
+	if (len < 16)
+	{
+		/* Two overlapping reads cover the key without a partial load. */
+		uint64_t lo = 0, hi = 0;
+
+		if (len >= 8)
+		{
+			memcpy(&lo, key, 8);
+			memcpy(&hi, key + len - 8, 8);
+		}
+		else if (len >= 4)
+		{
+			uint32_t a, b;
+
+			memcpy(&a, key, 4);
+			memcpy(&b, key + len - 4, 4);
+			lo = a;
+			hi = b;
+		}
+		else if (len > 0)
+			lo = ((uint64_t)key[0] << 16) | ((uint64_t)key[len >> 1] << 8) |
+				 key[len - 1];
+
+		s0 = _mm_aesenc_si128(
+			s0, _mm_set_epi64x((long long)hi, (long long)lo)
+		);
+	}
+	else
+	{
+		for (; n > 64; n -= 64, p += 64)
+		{
+			s0 = _mm_aesenc_si128(s0, aes_load(p));
+			s1 = _mm_aesenc_si128(s1, aes_load(p + 16));
+			s2 = _mm_aesenc_si128(s2, aes_load(p + 32));
+			s3 = _mm_aesenc_si128(s3, aes_load(p + 48));
+		}
+
+		/* Up to 64 bytes remain, the last block may overlap the one */
+		/* before it. */
+		for (; n > 16; n -= 16, p += 16)
+			s0 = _mm_aesenc_si128(s0, aes_load(p));
+
+		s1 = _mm_aesenc_si128(s1, aes_load(key + len - 16));
+	}
+
+	s0 = _mm_aesenc_si128(s0, s1);
+	s2 = _mm_aesenc_si128(s2, s3);
+	s0 = _mm_aesenc_si128(s0, s2);
+	s0 = _mm_aesenc_si128(s0, seed);
+	s0 = _mm_aesenc_si128(s0, seed);
+	*dest = (uint64_t)_mm_cvtsi128_si64(s0) ^
+			(uint64_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(s0, s0));
+}
+
+	#undef AES_HASH_TARGET
+#endif /* (defined __x86_64__ || defined _M_X64) && defined __GNUC__ */
+
+#endif /* AES_ROUND_HASH */
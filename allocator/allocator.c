@@ -0,0 +1,612 @@
+#define _DEFAULT_SOURCE /* MAP_ANONYMOUS, madvise */
+
+#include <stdbool.h> /* bool */
+#include <stddef.h>  /* max_align_t, size_t */
+#include <stdint.h>  /* PTRDIFF_MAX */
+#include <stdio.h>   /* perror */
+#include <string.h>  /* memset */
+
+#include "allocator.h"
+#include "xalloc/xalloc.h"
+
+#ifdef __unix__
+	#include <stdatomic.h> /* atomic_size_t */
+	#include <sys/mman.h>  /* mmap, munmap, madvise */
+	#include <unistd.h>    /* sysconf */
+	#define PAGES_MMAP
+#endif /* __unix__ */
+#if defined PAGES_MMAP && defined MAP_HUGETLB && defined MAP_HUGE_SHIFT
+	/* The default huge page can be 1 GiB, ask for 2 MiB ones explicitly. */
+	#define PAGES_HUGETLB (MAP_HUGETLB | (21 << MAP_HUGE_SHIFT))
+#endif /* defined PAGES_MMAP && defined MAP_HUGETLB && defined MAP_HUGE_SHIFT */
+#if defined PAGES_MMAP && !defined __STDC_NO_THREADS__
+	#include <threads.h> /* thrd_create, thrd_join */
+	#define PAGES_PREFAULT_THREADS
+#endif /* defined PAGES_MMAP && !defined __STDC_NO_THREADS__ */
+
+/*! size mappings are rounded up to, that of a huge page on x86-64. */
+#define PAGES_HUGE_SIZE ((size_t)2 << 20)
+/*! maximum number of threads faulting in the pages of a mapping. */
+#define PAGES_MAX_PREFAULT_THREADS 64
+
+#ifdef PAGES_MMAP
+/*! number of bytes mapped by `pages_alloc` and not yet unmapped. */
+static atomic_size_t pages_mapped_bytes;
+#endif /* PAGES_MMAP */
+
+/*!
+ * @brief round a size up to the strictest alignment of a fundamental type.
+ *
+ * @param size the size to round up.
+ * @returns the rounded size, smaller than `size` if it wrapped around.
+ */
+static size_t align_up(const size_t size)
+{
+	const size_t align = _alignof(max_align_t);
+
+	return ((size + align - 1) & ~(align - 1));
+}
+
+/*!
+ * @brief allocate memory from an `allocator`.
+ *
+ * @param a the allocator, NULL for `xmalloc`.
+ * @param size size in bytes to allocate.
+ * @returns pointer to the memory, NULL on failure.
+ */
+void *allocator_alloc(const allocator *const a, const len_ty size)
+{
+	if (!a)
+		return (xmalloc(size));
+
+	return (a->alloc(a->ctx, size));
+}
+
+/*!
+ * @brief allocate zeroed memory from an `allocator`.
+ *
+ * @param a the allocator, NULL for `xcalloc`.
+ * @param size size in bytes to allocate.
+ * @returns pointer to the memory, NULL on failure.
+ */
+void *allocator_calloc(const allocator *const a, const len_ty size)
+{
+	if (!a)
+		return (xcalloc(1, size));
+
+	void *const restrict ptr = a->alloc(a->ctx, size);
+
+	if (ptr)
+		memset(ptr, 0, size);
+
+	return (ptr);
+}
+
+/*!
+ * @brief return memory to the `allocator` it came from.
+ *
+ * @param a the allocator, NULL for `xfree`.
+ * @param ptr pointer to the memory, may be NULL.
+ * @param size size the memory was allocated with.
+ */
+void allocator_release(
+	const allocator *const a, void *const ptr, const len_ty size
+)
+{
+	if (!a)
+		xfree(ptr);
+	else if (ptr && a->release)
+		a->release(a->ctx, ptr, size);
+}
+
+/*###################################################################*/
+/*############################### arena #############################*/
+/*###################################################################*/
+
+/*!
+ * @brief a block of memory an `arena` hands out pieces of.
+ */
+struct arena_chunk
+{
+	/*! @private chunk allocated before this one. */
+	struct arena_chunk *prev;
+	/*! @private bytes after the header. */
+	size_t size;
+};
+
+struct arena
+{
+	/*! @private chunk pieces are handed out from. */
+	struct arena_chunk *chunk;
+	/*! @private bytes of `chunk` handed out so far. */
+	size_t used;
+	/*! @private size of new chunks. */
+	size_t chunk_size;
+};
+
+/*!
+ * @brief allocate memory from an `arena`.
+ *
+ * Requests larger than a chunk get a chunk of their own, the current chunk
+ * is kept for the requests after them.
+ *
+ * @param ctx the arena.
+ * @param size size in bytes to allocate.
+ * @returns pointer to the memory, NULL on failure.
+ */
+static void *arena_alloc(void *const ctx, const len_ty size)
+{
+	arena *const restrict a = ctx;
+	const size_t header = align_up(sizeof(struct arena_chunk));
+	const size_t need = align_up((size_t)size);
+
+	if (size < 0 || need < (size_t)size)
+		return (NULL);
+
+	if (!a->chunk || a->chunk->size - a->used < need)
+	{
+		const size_t chunk_size = need > a->chunk_size ? need : a->chunk_size;
+
+		/* overflow error. */
+		if (chunk_size > PTRDIFF_MAX - header)
+			return (NULL);
+
+		struct arena_chunk *const restrict chunk =
+			xmalloc((len_ty)(header + chunk_size));
+
+		if (!chunk)
+			return (NULL);
+
+		chunk->size = chunk_size;
+		if (a->chunk && need > a->chunk_size)
+		{
+			chunk->prev = a->chunk->prev;
+			a->chunk->prev = chunk;
+			return ((unsigned char *)chunk + header);
+		}
+
+		chunk->prev = a->chunk;
+		a->chunk = chunk;
+		a->used = 0;
+	}
+
+	void *const restrict ptr = (unsigned char *)a->chunk + header + a->used;
+
+	a->used += need;
+	return (ptr);
+}
+
+/*!
+ * @brief allocate and initialise an `arena`.
+ *
+ * Memory from an arena is only freed when the arena is deleted.
+ *
+ * @param chunk_size size in bytes of the chunks the arena allocates.
+ * @returns pointer to the arena, NULL on failure.
+ */
+arena *arena_new(const len_ty chunk_size)
+{
+	if (chunk_size < 1)
+		return (NULL);
+
+	arena *const restrict a = xmalloc(sizeof(*a));
+
+	if (!a)
+		return (NULL);
+
+	*a = (arena){.chunk_size = (size_t)chunk_size};
+	return (a);
+}
+
+/*!
+ * @brief free an `arena` and all the memory allocated from it.
+ *
+ * @param a the arena, may be NULL.
+ * @returns NULL always.
+ */
+void *arena_delete(arena *const restrict a)
+{
+	if (!a)
+		return (NULL);
+
+	for (struct arena_chunk *chunk = a->chunk; chunk;)
+	{
+		struct arena_chunk *const restrict prev = chunk->prev;
+
+		xfree(chunk);
+		chunk = prev;
+	}
+
+	*a = (arena){0};
+	return (xfree(a));
+}
+
+/*!
+ * @brief return an `allocator` that allocates from an `arena`.
+ *
+ * @param a the arena.
+ * @returns the allocator.
+ */
+allocator arena_allocator(arena *const restrict a)
+{
+	return ((allocator){.alloc = arena_alloc, .release = NULL, .ctx = a});
+}
+
+/*###################################################################*/
+/*############################### pool ##############################*/
+/*###################################################################*/
+
+/*!
+ * @brief header of a block of memory a `pool` is carved from.
+ */
+struct pool_chunk
+{
+	/*! @private chunk allocated before this one. */
+	struct pool_chunk *prev;
+};
+
+/*!
+ * @brief a free block of a `pool`.
+ */
+struct pool_block
+{
+	/*! @private next free block. */
+	struct pool_block *next;
+};
+
+struct pool
+{
+	/*! @private last chunk allocated. */
+	struct pool_chunk *chunk;
+	/*! @private first free block. */
+	struct pool_block *free_list;
+	/*! @private size of a block. */
+	size_t block_size;
+	/*! @private number of blocks in a chunk. */
+	size_t chunk_blocks;
+};
+
+/*!
+ * @brief allocate memory from a `pool`.
+ *
+ * Requests larger than a block are passed on to `xmalloc`.
+ *
+ * @param ctx the pool.
+ * @param size size in bytes to allocate.
+ * @returns pointer to the memory, NULL on failure.
+ */
+static void *pool_alloc(void *const ctx, const len_ty size)
+{
+	pool *const restrict p = ctx;
+
+	if (size < 0)
+		return (NULL);
+
+	if ((size_t)size > p->block_size)
+		return (xmalloc(size));
+
+	if (!p->free_list)
+	{
+		const size_t header = align_up(sizeof(struct pool_chunk));
+		struct pool_chunk *const restrict chunk =
+			xmalloc((len_ty)(header + p->block_size * p->chunk_blocks));
+
+		if (!chunk)
+			return (NULL);
+
+		chunk->prev = p->chunk;
+		p->chunk = chunk;
+		/* Threaded backwards so blocks are handed out in address order. */
+		for (size_t i = p->chunk_blocks; i > 0; i--)
+		{
+			struct pool_block *const restrict block =
+				(void *)((unsigned char *)chunk + header +
+						 (i - 1) * p->block_size);
+
+			block->next = p->free_list;
+			p->free_list = block;
+		}
+	}
+
+	struct pool_block *const restrict block = p->free_list;
+
+	p->free_list = block->next;
+	return (block);
+}
+
+/*!
+ * @brief return memory to a `pool`.
+ *
+ * @param ctx the pool.
+ * @param ptr pointer to the memory.
+ * @param size size the memory was allocated with.
+ */
+static void pool_release(void *const ctx, void *const ptr, const len_ty size)
+{
+	pool *const restrict p = ctx;
+
+	if ((size_t)size > p->block_size)
+	{
+		xfree(ptr);
+		return;
+	}
+
+	struct pool_block *const restrict block = ptr;
+
+	block->next = p->free_list;
+	p->free_list = block;
+}
+
+/*!
+ * @brief allocate and initialise a `pool`.
+ *
+ * @param block_size size in bytes of the blocks of the pool.
+ * @param chunk_blocks number of blocks allocated at a time.
+ * @returns pointer to the pool, NULL on failure.
+ */
+pool *pool_new(const len_ty block_size, const len_ty chunk_blocks)
+{
+	if (block_size < 1 || chunk_blocks < 1)
+		return (NULL);
+
+	const size_t header = align_up(sizeof(struct pool_chunk));
+	const size_t size = align_up(
+		(size_t)block_size > sizeof(struct pool_block)
+			? (size_t)block_size
+			: sizeof(struct pool_block)
+	);
+
+	/* overflow errors. */
+	if (size < (size_t)block_size ||
+		(size_t)chunk_blocks > (PTRDIFF_MAX - header) / size)
+		return (NULL);
+
+	pool *const restrict p = xmalloc(sizeof(*p));
+
+	if (!p)
+		return (NULL);
+
+	*p = (pool){.block_size = size, .chunk_blocks = (size_t)chunk_blocks};
+	return (p);
+}
+
+/*!
+ * @brief free a `pool` and all its blocks.
+ *
+ * Memory larger than a block is not freed, the HashMaps using the pool
+ * should be deleted first.
+ *
+ * @param p the pool, may be NULL.
+ * @returns NULL always.
+ */
+void *pool_delete(pool *const restrict p)
+{
+	if (!p)
+		return (NULL);
+
+	for (struct pool_chunk *chunk = p->chunk; chunk;)
+	{
+		struct pool_chunk *const restrict prev = chunk->prev;
+
+		xfree(chunk);
+		chunk = prev;
+	}
+
+	*p = (pool){0};
+	return (xfree(p));
+}
+
+/*!
+ * @brief return an `allocator` that allocates from a `pool`.
+ *
+ * @param p the pool.
+ * @returns the allocator.
+ */
+allocator pool_allocator(pool *const restrict p)
+{
+	return ((allocator){
+		.alloc = pool_alloc, .release = pool_release, .ctx = p
+	});
+}
+
+/*###################################################################*/
+/*############################### pages #############################*/
+/*###################################################################*/
+
+#ifdef PAGES_MMAP
+/*!
+ * @brief pages of a mapping for one thread to fault in.
+ */
+struct pages_range
+{
+	/*! @private first byte of the range. */
+	unsigned char *begin;
+	/*! @private byte after the end of the range. */
+	unsigned char *end;
+	/*! @private distance between the pages. */
+	size_t page_size;
+};
+
+/*!
+ * @brief fault in the pages of a range by writing to each of them.
+ *
+ * @param arg pointer to a `pages_range`.
+ * @returns 0 always.
+ */
+static int pages_prefault(void *const arg)
+{
+	const struct pages_range *const restrict range = arg;
+
+	/* The pages are still zero, writing a zero keeps them so. */
+	for (volatile unsigned char *p = range->begin; p < range->end;
+		 p += range->page_size)
+		*p = 0;
+
+	return (0);
+}
+
+/*!
+ * @brief fault in the pages of a mapping with a number of threads.
+ *
+ * @param ptr the mapping.
+ * @param length length of the mapping.
+ * @param threads number of threads to use, including the calling thread.
+ */
+static void pages_prefault_all(
+	unsigned char *const ptr, const size_t length, unsigned int threads
+)
+{
+	const long sys_page_size = sysconf(_SC_PAGESIZE);
+	const size_t page_size = sys_page_size > 0 ? (size_t)sys_page_size : 4096;
+	const size_t pages = length / page_size;
+	struct pages_range ranges[PAGES_MAX_PREFAULT_THREADS];
+
+	if (threads > PAGES_MAX_PREFAULT_THREADS)
+		threads = PAGES_MAX_PREFAULT_THREADS;
+
+	for (unsigned int t = 0; t < threads; t++)
+		ranges[t] = (struct pages_range){
+			.begin = ptr + page_size * (pages * t / threads),
+			.end = ptr + page_size * (pages * (t + 1) / threads),
+			.page_size = page_size,
+		};
+
+	#ifdef PAGES_PREFAULT_THREADS
+	thrd_t ids[PAGES_MAX_PREFAULT_THREADS];
+	bool started[PAGES_MAX_PREFAULT_THREADS] = {0};
+
+	/* The calling thread takes the first range, and any range whose */
+	/* thread could not be started. */
+	for (unsigned int t = 1; t < threads; t++)
+		started[t] = thrd_create(&ids[t], pages_prefault, &ranges[t]) ==
+					 thrd_success;
+
+	pages_prefault(&ranges[0]);
+	for (unsigned int t = 1; t < threads; t++)
+	{
+		if (started[t])
+			thrd_join(ids[t], NULL);
+		else
+			pages_prefault(&ranges[t]);
+	}
+	#else
+	for (unsigned int t = 0; t < threads; t++)
+		pages_prefault(&ranges[t]);
+	#endif /* PAGES_PREFAULT_THREADS */
+}
+#endif /* PAGES_MMAP */
+
+/*!
+ * @brief length of the mapping that holds a number of bytes.
+ *
+ * @param size number of bytes.
+ * @returns the length, 0 if it cannot be represented.
+ */
+static size_t pages_length(const len_ty size)
+{
+	if (size < 1 || (size_t)size > PTRDIFF_MAX - PAGES_HUGE_SIZE)
+		return (0);
+
+	return (((size_t)size + PAGES_HUGE_SIZE - 1) & ~(PAGES_HUGE_SIZE - 1));
+}
+
+/*!
+ * @brief allocate zeroed memory straight from the kernel, backed by huge
+ * pages where the system allows.
+ *
+ * Reserved huge pages are used first, then transparent huge pages. The
+ * mapping is rounded up to a whole number of huge pages, so this is meant
+ * for blocks of several megabytes. Without `mmap` it falls back to
+ * `xcalloc`.
+ *
+ * @param size size in bytes to allocate.
+ * @param prefault_threads number of threads that fault in the pages before
+ * they are returned, 0 to let them fault in on first use.
+ * @returns pointer to the memory, NULL on failure.
+ */
+void *pages_alloc(const len_ty size, const unsigned int prefault_threads)
+{
+#ifdef PAGES_MMAP
+	const size_t length = pages_length(size);
+
+	if (!length)
+		return (NULL);
+
+	void *restrict ptr = MAP_FAILED;
+
+	#ifdef PAGES_HUGETLB
+	ptr = mmap(
+		NULL, length, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | PAGES_HUGETLB, -1, 0
+	);
+	#endif /* PAGES_HUGETLB */
+	if (ptr == MAP_FAILED)
+	{
+		ptr = mmap(
+			NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+			-1, 0
+		);
+		if (ptr == MAP_FAILED)
+		{
+			perror("ERROR:pages_alloc");
+			return (NULL);
+		}
+
+	#ifdef MADV_HUGEPAGE
+		/* Only a hint, the mapping works the same without it. */
+		madvise(ptr, length, MADV_HUGEPAGE);
+	#endif /* MADV_HUGEPAGE */
+	}
+
+	if (prefault_threads > 0)
+		pages_prefault_all(ptr, length, prefault_threads);
+
+	atomic_fetch_add(&pages_mapped_bytes, length);
+	return (ptr);
+#else
+	(void)prefault_threads;
+	return (xcalloc(1, size));
+#endif /* PAGES_MMAP */
+}
+
+/*!
+ * @brief free memory allocated by `pages_alloc`.
+ *
+ * @param ptr pointer to the memory, may be NULL.
+ * @param size size the memory was allocated with.
+ */
+void pages_release(void *const ptr, const len_ty size)
+{
+#ifdef PAGES_MMAP
+	const size_t length = pages_length(size);
+
+	if (!ptr)
+		return;
+
+	if (munmap(ptr, length))
+	{
+		perror("ERROR:pages_release");
+		return;
+	}
+
+	atomic_fetch_sub(&pages_mapped_bytes, length);
+#else
+	(void)size;
+	xfree(ptr);
+#endif /* PAGES_MMAP */
+}
+
+/*!
+ * @brief report how much memory `pages_alloc` has mapped.
+ *
+ * @returns number of bytes mapped and not yet released, always 0 when the
+ * memory comes from `xcalloc`.
+ */
+size_t pages_mapped(void)
+{
+#ifdef PAGES_MMAP
+	return (atomic_load(&pages_mapped_bytes));
+#else
+	return (0);
+#endif /* PAGES_MMAP */
+}
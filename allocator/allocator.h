@@ -0,0 +1,60 @@
+#ifndef DS_ALLOCATOR
+#define DS_ALLOCATOR
+
+#include "compiler_attributes_macros.h"
+#include "len_type.h"
+
+/*!
+ * @brief a source of memory that can be given to a HashMap.
+ *
+ * An allocator is not locked, it should only be used by one thread at a
+ * time.
+ */
+typedef struct allocator
+{
+	/*! @public allocate `size` bytes, returns NULL on failure. */
+	void *(*alloc)(void *const ctx, const len_ty size);
+	/*! @public free a block of `size` bytes returned by `alloc`. When NULL */
+	/*! blocks are only freed all at once, by the owner of `ctx`. */
+	void (*release)(void *const ctx, void *const ptr, const len_ty size);
+	/*! @public state passed to `alloc` and `release`. */
+	void *ctx;
+} allocator;
+
+/*!
+ * @brief allocator that hands out consecutive pieces of large chunks.
+ */
+typedef struct arena arena;
+
+/*!
+ * @brief allocator of blocks of one size, recycled through a free list.
+ */
+typedef struct pool pool;
+
+void *allocator_alloc(const allocator *const a, const len_ty size) _malloc;
+void *allocator_calloc(const allocator *const a, const len_ty size) _malloc;
+void allocator_release(
+	const allocator *const a, void *const ptr, const len_ty size
+);
+
+/* arena */
+
+void *arena_delete(arena *const restrict a);
+arena *arena_new(const len_ty chunk_size) _malloc _malloc_free(arena_delete);
+allocator arena_allocator(arena *const restrict a);
+
+/* pool */
+
+void *pool_delete(pool *const restrict p);
+pool *pool_new(const len_ty block_size, const len_ty chunk_blocks)
+	_malloc _malloc_free(pool_delete);
+allocator pool_allocator(pool *const restrict p);
+
+/* pages */
+
+void pages_release(void *const ptr, const len_ty size);
+void *pages_alloc(const len_ty size, const unsigned int prefault_threads)
+	_malloc;
+size_t pages_mapped(void);
+
+#endif /* DS_ALLOCATOR */
@@ -0,0 +1,211 @@
+/* batch_HashMap.c
+ *
+ * Compares `hm_int_search_batch` with a loop of `hm_int_search` on a table
+ * much larger than the caches, the way a lookup stage resolving many
+ * identifiers per request would use the HashMap. The hits are then resolved
+ * again through interned handles with `hm_sym_search_interned`.
+ *
+ * Example usage (after building):
+ *   ./batch_murmur3 -n 1000000 -q 4000000 -b 1024 -s 42
+ *
+ */
+
+#define _POSIX_C_SOURCE 199309L /* clock_gettime */
+
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "HashMap.h"
+#include "xalloc.h"
+
+#define KEY_LEN 12 /* "sym_%08x" */
+
+/* RNG helpers */
+static inline uint32_t xorshift32(uint32_t *s)
+{
+	uint32_t x = *s;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*s = x;
+	return x;
+}
+
+static double seconds_since(const struct timespec start)
+{
+	struct timespec end;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - start.tv_sec + (end.tv_nsec - start.tv_nsec) / 1e9);
+}
+
+int main(int argc, char **argv)
+{
+	size_t N_keys = 1000000;    /* entries in the map */
+	size_t N_queries = 4000000; /* lookups per run */
+	size_t batch_size = 1024;   /* keys per `search_batch` call */
+	uint32_t seed = 42;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:q:b:s:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'n':
+			N_keys = (size_t)atoll(optarg);
+			break;
+		case 'q':
+			N_queries = (size_t)atoll(optarg);
+			break;
+		case 'b':
+			batch_size = (size_t)atoll(optarg);
+			break;
+		case 's':
+			seed = (uint32_t)atoi(optarg);
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (N_keys < 1 || batch_size < 1)
+	{
+		fprintf(
+			stderr, "usage: %s [-n keys] [-q queries] [-b batch] [-s seed]\n",
+			argv[0]
+		);
+		return 2;
+	}
+
+	char *const key_buf = xmalloc(N_queries * (KEY_LEN + 1) + 1);
+	u8mem *const queries = xmalloc(sizeof(*queries) * (N_queries + 1));
+	size_t *const ids = xmalloc(sizeof(*ids) * (N_queries + 1));
+	int **const out = xmalloc(sizeof(*out) * (batch_size + 1));
+	const Interned_sym **const handles =
+		xmalloc(sizeof(*handles) * (N_keys + 1));
+	struct HashMap_int *hm = hm_int_new(N_keys);
+	struct HashMap_sym *syms = hm_sym_new(N_keys);
+
+	if (!key_buf || !queries || !ids || !out || !handles || !hm || !syms)
+	{
+		fprintf(stderr, "failed to allocate the benchmark\n");
+		return 2;
+	}
+
+	/* Keys 0 to N_keys - 1 are in the map. */
+	for (size_t i = 0; i < N_keys; ++i)
+	{
+		char key[KEY_LEN + 1];
+
+		snprintf(key, sizeof(key), "sym_%08x", (unsigned int)i);
+		const u8mem k = {.len = KEY_LEN, .buf = (unsigned char *)key};
+
+		handles[i] = hm_sym_intern(&syms, k);
+		if (!hm_int_insert(&hm, k, (int)i) || !handles[i])
+		{
+			fprintf(stderr, "failed to insert key %zu\n", i);
+			return 2;
+		}
+
+		*hm_sym_search_interned(syms, handles[i]) = (int)i;
+	}
+
+	/* About half of the queries miss. */
+	uint32_t rng = seed;
+
+	for (size_t i = 0; i < N_queries; ++i)
+	{
+		char *const key = &key_buf[i * (KEY_LEN + 1)];
+
+		ids[i] = xorshift32(&rng) % (N_keys * 2);
+		snprintf(key, KEY_LEN + 1, "sym_%08x", (unsigned int)ids[i]);
+		queries[i] = (u8mem){.len = KEY_LEN, .buf = (unsigned char *)key};
+	}
+
+	struct timespec t0;
+	long long sum_single = 0, sum_batch = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (size_t i = 0; i < N_queries; ++i)
+	{
+		const int *const p = hm_int_search(hm, queries[i]);
+
+		sum_single += p ? *p : -1;
+	}
+
+	const double single = seconds_since(t0);
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (size_t i = 0; i < N_queries; i += batch_size)
+	{
+		const size_t n =
+			N_queries - i < batch_size ? N_queries - i : batch_size;
+
+		hm_int_search_batch(hm, &queries[i], (len_ty)n, out);
+		for (size_t j = 0; j < n; ++j)
+			sum_batch += out[j] ? *out[j] : -1;
+	}
+
+	const double batch = seconds_since(t0);
+	long long sum_key = 0, sum_handle = 0;
+	size_t hits = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (size_t i = 0; i < N_queries; ++i)
+	{
+		if (ids[i] < N_keys)
+			sum_key += *hm_sym_search(syms, queries[i]);
+	}
+
+	const double by_key = seconds_since(t0);
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (size_t i = 0; i < N_queries; ++i)
+	{
+		if (ids[i] < N_keys)
+		{
+			sum_handle += *hm_sym_search_interned(syms, handles[ids[i]]);
+			hits++;
+		}
+	}
+
+	const double by_handle = seconds_since(t0);
+
+	printf("keys=%zu queries=%zu batch=%zu\n", N_keys, N_queries, batch_size);
+	printf(
+		"search:       time=%.6fs ns/lookup=%.1f\n", single,
+		single * 1e9 / N_queries
+	);
+	printf(
+		"search_batch: time=%.6fs ns/lookup=%.1f speedup=%.2fx\n", batch,
+		batch * 1e9 / N_queries, single / batch
+	);
+	if (hits > 0)
+		printf(
+			"search_interned: ns/hit=%.1f speedup=%.2fx\n",
+			by_handle * 1e9 / hits, by_key / by_handle
+		);
+	if (sum_single != sum_batch)
+	{
+		fprintf(stderr, "search and search_batch disagree\n");
+		return 1;
+	}
+
+	if (sum_key != sum_handle)
+	{
+		fprintf(stderr, "search and search_interned disagree\n");
+		return 1;
+	}
+
+	hm_sym_delete(syms, NULL);
+	hm_int_delete(hm, NULL);
+	xfree(handles);
+	xfree(out);
+	xfree(ids);
+	xfree(queries);
+	xfree(key_buf);
+	return 0;
+}
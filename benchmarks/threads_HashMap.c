@@ -0,0 +1,388 @@
+/* threads_HashMap.c
+ *
+ * Runs a mix of inserts, searches and removes from 1 up to a number of
+ * threads against one of the thread safe HashMaps, to compare how they
+ * scale. For each thread count the throughput and the percentiles of the
+ * time taken by single operations are printed.
+ *
+ * Maps:
+ *   concurrent  `hm_int_concurrent_*`, lock striped.
+ *   sharded     `hm_int_sharded_*`, shards that grow on their own.
+ *   rcu         `hm_id_rcu_*`, lock free searches. Every write copies the
+ *               whole map, so give it few keys and mostly searches.
+ *
+ * Example usage (after building):
+ *   ./threads_murmur3 -m sharded -t 8 -n 1000000 -k 1000000 -r 0.8 -i 0.1
+ *
+ */
+
+#define _POSIX_C_SOURCE 199309L /* clock_gettime */
+
+#include <getopt.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+#include <time.h>
+
+#include "HashMap.h"
+#include "xalloc.h"
+
+#define MAX_THREADS 64
+
+/* RNG helpers */
+static inline uint32_t xorshift32(uint32_t *s)
+{
+	uint32_t x = *s;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*s = x;
+	return x;
+}
+
+static inline uint64_t now_ns(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t)t.tv_sec * 1000000000u + (uint64_t)t.tv_nsec;
+}
+
+/* Maps under test, keys are numbers so every map can take them. */
+
+struct map_ops
+{
+	const char *name;
+	void *(*create)(size_t capacity, unsigned int param);
+	void (*destroy)(void *map);
+	bool (*insert)(void *map, uint64_t key, int data);
+	bool (*search)(void *map, uint64_t key, int *dest);
+	bool (*remove)(void *map, uint64_t key, int *dest);
+};
+
+#define INT_KEY(key) ((u8mem){.len = sizeof(key), .buf = (unsigned char *)&key})
+
+static void *concurrent_create(size_t capacity, unsigned int stripes)
+{
+	return hm_int_concurrent_new((len_ty)capacity, stripes ? stripes : 64);
+}
+
+static void concurrent_destroy(void *map)
+{
+	hm_int_concurrent_delete(map, NULL);
+}
+
+static bool concurrent_insert(void *map, uint64_t key, int data)
+{
+	return hm_int_concurrent_insert(map, INT_KEY(key), data);
+}
+
+static bool concurrent_search(void *map, uint64_t key, int *dest)
+{
+	return hm_int_concurrent_search(map, dest, INT_KEY(key));
+}
+
+static bool concurrent_remove(void *map, uint64_t key, int *dest)
+{
+	return hm_int_concurrent_remove(map, dest, INT_KEY(key));
+}
+
+static void *sharded_create(size_t capacity, unsigned int bits)
+{
+	return hm_int_sharded_new((len_ty)capacity, bits ? bits : 6);
+}
+
+static void sharded_destroy(void *map) { hm_int_sharded_delete(map, NULL); }
+
+static bool sharded_insert(void *map, uint64_t key, int data)
+{
+	return hm_int_sharded_insert(map, INT_KEY(key), data);
+}
+
+static bool sharded_search(void *map, uint64_t key, int *dest)
+{
+	return hm_int_sharded_search(map, dest, INT_KEY(key));
+}
+
+static bool sharded_remove(void *map, uint64_t key, int *dest)
+{
+	return hm_int_sharded_remove(map, dest, INT_KEY(key));
+}
+
+static void *rcu_create(size_t capacity, unsigned int unused)
+{
+	(void)unused;
+	return hm_id_rcu_new((len_ty)capacity);
+}
+
+static void rcu_destroy(void *map) { hm_id_rcu_delete(map, NULL); }
+
+static bool rcu_insert(void *map, uint64_t key, int data)
+{
+	return hm_id_rcu_insert(map, key, data);
+}
+
+static bool rcu_search(void *map, uint64_t key, int *dest)
+{
+	return hm_id_rcu_search(map, dest, key);
+}
+
+static bool rcu_remove(void *map, uint64_t key, int *dest)
+{
+	return hm_id_rcu_remove(map, dest, key);
+}
+
+static const struct map_ops maps[] = {
+	{"concurrent", concurrent_create, concurrent_destroy, concurrent_insert,
+	 concurrent_search, concurrent_remove},
+	{"sharded", sharded_create, sharded_destroy, sharded_insert,
+	 sharded_search, sharded_remove},
+	{"rcu", rcu_create, rcu_destroy, rcu_insert, rcu_search, rcu_remove},
+};
+
+/* Workers */
+
+struct worker
+{
+	const struct map_ops *ops;
+	void *map;
+	const atomic_bool *go;
+	size_t n_ops;
+	size_t key_range;
+	uint32_t search_cut; /* random numbers below this search */
+	uint32_t insert_cut; /* then below this insert, the rest remove */
+	size_t sample_every;
+	uint32_t rng;
+	uint64_t *latencies; /* ns, one every `sample_every` operations */
+	size_t samples;
+	size_t failed;
+};
+
+static int worker_run(void *arg)
+{
+	struct worker *const w = arg;
+
+	while (!atomic_load_explicit(w->go, memory_order_acquire))
+		thrd_yield();
+
+	for (size_t i = 0; i < w->n_ops; ++i)
+	{
+		const uint32_t op = xorshift32(&w->rng);
+		const uint64_t key = xorshift32(&w->rng) % w->key_range;
+		const bool timed = i % w->sample_every == 0;
+		const uint64_t start = timed ? now_ns() : 0;
+		int data;
+
+		if (op < w->search_cut)
+			w->ops->search(w->map, key, &data);
+		else if (op < w->insert_cut)
+			w->failed += !w->ops->insert(w->map, key, (int)key);
+		else
+			w->ops->remove(w->map, key, &data);
+
+		if (timed)
+			w->latencies[w->samples++] = now_ns() - start;
+	}
+
+	return 0;
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+	const uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+static uint64_t percentile(const uint64_t *sorted, size_t n, double p)
+{
+	return n ? sorted[(size_t)(p * (double)(n - 1) + 0.5)] : 0;
+}
+
+int main(int argc, char **argv)
+{
+	const char *map_name = "concurrent";
+	unsigned int max_threads = 4;
+	size_t N_ops = 200000;      /* operations per thread */
+	size_t key_range = 100000;  /* keys are 0 to key_range - 1 */
+	double search_ratio = 0.8;  /* fraction of operations that search */
+	double insert_ratio = 0.1;  /* fraction that insert, the rest remove */
+	size_t sample_every = 1;    /* time one operation in this many */
+	unsigned int map_param = 0; /* stripes or shard bits, 0 for default */
+	uint32_t seed = 42;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "m:t:n:k:r:i:l:p:s:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'm':
+			map_name = optarg;
+			break;
+		case 't':
+			max_threads = (unsigned int)atoi(optarg);
+			break;
+		case 'n':
+			N_ops = (size_t)atoll(optarg);
+			break;
+		case 'k':
+			key_range = (size_t)atoll(optarg);
+			break;
+		case 'r':
+			search_ratio = atof(optarg);
+			break;
+		case 'i':
+			insert_ratio = atof(optarg);
+			break;
+		case 'l':
+			sample_every = (size_t)atoll(optarg);
+			break;
+		case 'p':
+			map_param = (unsigned int)atoi(optarg);
+			break;
+		case 's':
+			seed = (uint32_t)atoi(optarg);
+			break;
+		default:
+			break;
+		}
+	}
+
+	const struct map_ops *ops = NULL;
+
+	for (size_t i = 0; i < sizeof(maps) / sizeof(*maps); ++i)
+	{
+		if (strcmp(maps[i].name, map_name) == 0)
+			ops = &maps[i];
+	}
+
+	if (!ops || max_threads < 1 || max_threads > MAX_THREADS || key_range < 1 ||
+		sample_every < 1 || search_ratio < 0 || insert_ratio < 0 ||
+		search_ratio + insert_ratio > 1)
+	{
+		fprintf(
+			stderr,
+			"usage: %s [-m concurrent|sharded|rcu] [-t threads] [-n ops] "
+			"[-k keys] [-r search] [-i insert] [-l sample] [-p param] "
+			"[-s seed]\n",
+			argv[0]
+		);
+		return 2;
+	}
+
+	const size_t per_thread = (N_ops + sample_every - 1) / sample_every;
+	uint64_t *const latencies =
+		xmalloc(sizeof(*latencies) * (per_thread * max_threads + 1));
+
+	if (!latencies)
+	{
+		fprintf(stderr, "failed to allocate the benchmark\n");
+		return 2;
+	}
+
+	printf(
+		"map=%s ops/thread=%zu keys=%zu search=%.3g insert=%.3g "
+		"remove=%.3g\n",
+		ops->name, N_ops, key_range, search_ratio, insert_ratio,
+		1 - search_ratio - insert_ratio
+	);
+	printf(
+		"%7s %12s %8s %8s %8s %8s %8s\n", "threads", "ops/s", "p50(ns)",
+		"p90", "p99", "p99.9", "max"
+	);
+
+	/* 1, 2, 4, ... threads, then the maximum. */
+	for (unsigned int threads = 1; threads <= max_threads;
+		 threads = threads * 2 > max_threads && threads < max_threads
+					   ? max_threads
+					   : threads * 2)
+	{
+		void *const map = ops->create(key_range, map_param);
+
+		if (!map)
+		{
+			fprintf(stderr, "failed to create the map\n");
+			return 2;
+		}
+
+		/* Start about half full, the mix keeps it there when inserts and */
+		/* removes are equally likely. */
+		for (size_t k = 0; k < key_range; k += 2)
+		{
+			if (!ops->insert(map, k, (int)k))
+			{
+				fprintf(stderr, "failed to insert key %zu\n", k);
+				return 2;
+			}
+		}
+
+		struct worker workers[MAX_THREADS];
+		thrd_t ids[MAX_THREADS];
+		atomic_bool go = false;
+
+		for (unsigned int t = 0; t < threads; ++t)
+		{
+			workers[t] = (struct worker){
+				.ops = ops,
+				.map = map,
+				.go = &go,
+				.n_ops = N_ops,
+				.key_range = key_range,
+				.search_cut = (uint32_t)(search_ratio * UINT32_MAX),
+				.insert_cut =
+					(uint32_t)((search_ratio + insert_ratio) * UINT32_MAX),
+				.sample_every = sample_every,
+				.rng = (seed ^ (t * 0x9e3779b9u)) | 1,
+				.latencies = &latencies[per_thread * t],
+			};
+			if (thrd_create(&ids[t], worker_run, &workers[t]) != thrd_success)
+			{
+				fprintf(stderr, "failed to start thread %u\n", t);
+				return 2;
+			}
+		}
+
+		const uint64_t start = now_ns();
+
+		atomic_store_explicit(&go, true, memory_order_release);
+		for (unsigned int t = 0; t < threads; ++t)
+			thrd_join(ids[t], NULL);
+
+		const double seconds = (double)(now_ns() - start) / 1e9;
+		size_t samples = 0, failed = 0;
+
+		/* Gather the samples of every thread at the front. */
+		for (unsigned int t = 0; t < threads; ++t)
+		{
+			memmove(
+				&latencies[samples], workers[t].latencies,
+				sizeof(*latencies) * workers[t].samples
+			);
+			samples += workers[t].samples;
+			failed += workers[t].failed;
+		}
+
+		qsort(latencies, samples, sizeof(*latencies), compare_u64);
+		printf(
+			"%7u %12.0f %8llu %8llu %8llu %8llu %8llu\n", threads,
+			(double)N_ops * threads / seconds,
+			(unsigned long long)percentile(latencies, samples, 0.5),
+			(unsigned long long)percentile(latencies, samples, 0.9),
+			(unsigned long long)percentile(latencies, samples, 0.99),
+			(unsigned long long)percentile(latencies, samples, 0.999),
+			(unsigned long long)percentile(latencies, samples, 1)
+		);
+		ops->destroy(map);
+		if (failed)
+		{
+			fprintf(stderr, "%zu inserts failed\n", failed);
+			return 1;
+		}
+	}
+
+	xfree(latencies);
+	return 0;
+}
@@ -47,24 +47,56 @@ static struct hashmap_stats hmstats_get(const HashMap_int *const map)
 	size_t total_chain_len = 0;
 	len_ty i = map->capacity;
 
-#ifdef CELLAR_COALESCED_HASHING
+#if defined SWISS_TABLE_PROBING || defined ROBIN_HOOD_HASHING
+	/* No chains, every live bucket counts as one with its probe length. */
+	while (i > 0)
+	{
+		i--;
+		if (!map->arr[i].key_len)
+			continue;
+
+		const len_ty home = map->arr[i].hash % map->capacity;
+		const unsigned int len =
+			(i - home + map->capacity) % map->capacity + 1;
+
+		stats.chains++;
+		if (len > stats.longest_chain_len)
+			stats.longest_chain_len = len;
+
+		total_chain_len += len;
+	}
+
+	stats.avg_chain_len = total_chain_len / (double)stats.chains;
+	return (stats);
+#else
+	#ifdef CELLAR_COALESCED_HASHING
 	i += map->cellar.capacity;
-#endif /* CELLAR_COALESCED_HASHING */
+	#endif /* CELLAR_COALESCED_HASHING */
+	#ifdef HOT_COLD_SPLIT
+	/* The Links are stored right after the last Bucket. */
+	const Link_int *const links = (const Link_int *)&map->arr[i];
+	#endif /* HOT_COLD_SPLIT */
 	while (i > 0)
 	{
 		i--;
 		const Bucket_int *bkt = &map->arr[i];
 
-		if (bkt->key && !bkt->prev_pos)
+		if (bkt->key_len && !bkt->prev_pos)
 		{
 			stats.chains++;
 			unsigned int len = 1;
 
+	#ifdef HOT_COLD_SPLIT
+			for (pos_ty pos = links[i].next_pos; pos;
+				 pos = links[pos - 1].next_pos)
+				len++;
+	#else
 			while (bkt->next_pos)
 			{
 				len++;
 				bkt = &map->arr[bkt->next_pos - 1];
 			}
+	#endif /* HOT_COLD_SPLIT */
 
 			if (len > stats.longest_chain_len)
 				stats.longest_chain_len = len;
@@ -75,6 +107,7 @@ static struct hashmap_stats hmstats_get(const HashMap_int *const map)
 
 	stats.avg_chain_len = total_chain_len / (double)stats.chains;
 	return (stats);
+#endif /* defined SWISS_TABLE_PROBING || defined ROBIN_HOOD_HASHING */
 }
 
 static void hmstats_print(const HashMap_int *const map)
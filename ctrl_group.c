@@ -0,0 +1,147 @@
+#ifndef SWISS_TABLE_CONTROL_GROUP
+#define SWISS_TABLE_CONTROL_GROUP
+
+/*
+ * Control bytes for the "Swiss table" probing engine.
+ *
+ * Every slot of the table has a 1 byte tag in a dense side array:
+ * `CTRL_EMPTY`, `CTRL_DELETED` or the top 7 bits of the hash of the key in
+ * the slot (high bit clear). A group of `CTRL_GROUP_WIDTH` tags is compared
+ * at once and the result is returned as a bitmask, bit `i` set meaning the
+ * tag at `ctrl[i]` matched.
+ *
+ * https://abseil.io/about/design/swisstables
+ */
+
+#include <limits.h> /* CHAR_BIT */
+#include <stdint.h> /* uint32_t */
+
+#if defined __AVX2__ || defined __SSE2__
+	#include <immintrin.h>
+#endif /* defined __AVX2__ || defined __SSE2__ */
+
+/*! @brief tag of a slot that has never been used. */
+#define CTRL_EMPTY ((unsigned char)0x80)
+/*! @brief tag of a slot whose entry has been removed (tombstone). */
+#define CTRL_DELETED ((unsigned char)0xFE)
+
+#if defined __AVX2__
+	#define CTRL_GROUP_WIDTH 32
+#else
+	#define CTRL_GROUP_WIDTH 16
+#endif /* defined __AVX2__ */
+
+/*! @brief bitmask of the slots in a group that matched a query. */
+typedef uint32_t ctrl_mask;
+
+/*!
+ * @brief compare every tag in a group with a byte.
+ *
+ * @param ctrl pointer to the first tag in the group.
+ * @param tag the byte to compare with.
+ * @returns bitmask of the matching tags.
+ */
+static inline ctrl_mask
+ctrl_group_match(const unsigned char *const restrict ctrl, unsigned char tag)
+{
+#if defined __AVX2__
+	const __m256i group = _mm256_loadu_si256((const __m256i *)ctrl);
+
+	return (_mm256_movemask_epi8(
+		_mm256_cmpeq_epi8(group, _mm256_set1_epi8((char)tag))
+	));
+#elif defined __SSE2__
+	const __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+
+	return (_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)tag)))
+	);
+#else
+	ctrl_mask mask = 0;
+
+	for (unsigned int i = 0; i < CTRL_GROUP_WIDTH; i++)
+		mask |= (ctrl_mask)(ctrl[i] == tag) << i;
+
+	return (mask);
+#endif /* defined __AVX2__ */
+}
+
+/*!
+ * @brief find the never used slots in a group.
+ *
+ * @param ctrl pointer to the first tag in the group.
+ * @returns bitmask of the empty slots.
+ */
+static inline ctrl_mask
+ctrl_group_match_empty(const unsigned char *const restrict ctrl)
+{
+	return (ctrl_group_match(ctrl, CTRL_EMPTY));
+}
+
+/*!
+ * @brief find the slots in a group that can take a new entry.
+ *
+ * @param ctrl pointer to the first tag in the group.
+ * @returns bitmask of the empty and deleted slots.
+ */
+static inline ctrl_mask
+ctrl_group_match_free(const unsigned char *const restrict ctrl)
+{
+	/* Only the empty and deleted tags have the high bit set. */
+#if defined __AVX2__
+	return (_mm256_movemask_epi8(_mm256_loadu_si256((const __m256i *)ctrl)));
+#elif defined __SSE2__
+	return (_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)ctrl)));
+#else
+	ctrl_mask mask = 0;
+
+	for (unsigned int i = 0; i < CTRL_GROUP_WIDTH; i++)
+		mask |= (ctrl_mask)(ctrl[i] >> (CHAR_BIT - 1)) << i;
+
+	return (mask);
+#endif /* defined __AVX2__ */
+}
+
+/*!
+ * @brief position of the lowest set bit in a non-zero mask.
+ *
+ * @param mask the bitmask.
+ * @returns number of clear bits below the lowest set bit.
+ */
+static inline unsigned int ctrl_mask_trailing_zeros(ctrl_mask mask)
+{
+#ifdef __GNUC__
+	return (__builtin_ctz(mask));
+#else
+	unsigned int n = 0;
+
+	for (; !(mask & 1); mask >>= 1)
+		n++;
+
+	return (n);
+#endif /* __GNUC__ */
+}
+
+/*!
+ * @brief number of clear bits above the highest set bit of a group mask.
+ *
+ * @param mask a non-zero bitmask of a group.
+ * @returns count of the clear bits, counted from bit `CTRL_GROUP_WIDTH - 1`.
+ */
+static inline unsigned int ctrl_mask_leading_zeros(ctrl_mask mask)
+{
+#ifdef __GNUC__
+	return (
+		__builtin_clz(mask) - (sizeof(mask) * CHAR_BIT - CTRL_GROUP_WIDTH)
+	);
+#else
+	unsigned int n = 0;
+
+	for (ctrl_mask bit = (ctrl_mask)1 << (CTRL_GROUP_WIDTH - 1);
+		 !(mask & bit); bit >>= 1)
+		n++;
+
+	return (n);
+#endif /* __GNUC__ */
+}
+
+#endif /* SWISS_TABLE_CONTROL_GROUP */
@@ -0,0 +1,39 @@
+#ifndef HASHMAP_HASH_DISPATCH
+#define HASHMAP_HASH_DISPATCH
+
+/*
+ * Picks the fastest 64 bit hash the CPU running the program supports.
+ *
+ * The choice is made once at startup, before `main`, and never changes
+ * afterwards so every hash computed by the program uses the same kernel.
+ */
+
+#include "aeshash.c"
+#include "wyhash.c"
+
+/*! @brief type of a hash function writing a 64 bit hash to `out`. */
+typedef void hash_kernel(
+	const unsigned char *const restrict key, const size_t len,
+	void *const restrict out
+);
+
+#ifdef AES_ROUND_HASH_SUPPORTED
+/*! @brief the hash function used by `hash_dispatch`. */
+static hash_kernel *hash_dispatch_kernel = wyhash;
+
+/*!
+ * @brief select the hash function for this CPU.
+ */
+__attribute__((constructor)) static void hash_dispatch_select(void)
+{
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("aes"))
+		hash_dispatch_kernel = aes_hash;
+}
+
+	#define hash_dispatch(key, len, out) hash_dispatch_kernel(key, len, out)
+#else
+	#define hash_dispatch(key, len, out) wyhash(key, len, out)
+#endif /* AES_ROUND_HASH_SUPPORTED */
+
+#endif /* HASHMAP_HASH_DISPATCH */
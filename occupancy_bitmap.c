@@ -0,0 +1,136 @@
+#ifndef HASHMAP_OCCUPANCY_BITMAP
+#define HASHMAP_OCCUPANCY_BITMAP
+
+/*
+ * Occupancy bitmap for finding unused Buckets.
+ *
+ * Bit `i % BITMAP_WORD_BIT` of word `i / BITMAP_WORD_BIT` is set while slot
+ * `i` holds a live Bucket, a free slot is then found a whole word at a time.
+ */
+
+#include <limits.h> /* CHAR_BIT */
+#include <stdalign.h> /* alignof */
+#include <stdint.h> /* uint64_t, uintptr_t */
+
+#include "len_type.h"
+
+/*! @brief type of a word of the bitmap. */
+typedef uint64_t bitmap_word;
+
+#define BITMAP_WORD_BIT (sizeof(bitmap_word) * CHAR_BIT)
+/* Bytes to allocate for the bitmap of `slots` slots, including padding. */
+#define BITMAP_SIZE(slots)                                                    \
+	(((size_t)(slots) + BITMAP_WORD_BIT - 1) / BITMAP_WORD_BIT *              \
+		 sizeof(bitmap_word) +                                                 \
+	 alignof(bitmap_word) - 1)
+
+/*!
+ * @brief get the bitmap stored at an address.
+ *
+ * @param ptr address of the allocation that holds the bitmap.
+ * @returns pointer to the first word, aligned for `bitmap_word`.
+ */
+static inline bitmap_word *bitmap_align(unsigned char *const ptr)
+{
+	const uintptr_t misalign = (uintptr_t)ptr % alignof(bitmap_word);
+
+	return (
+		(bitmap_word *)(misalign ? ptr + alignof(bitmap_word) - misalign : ptr)
+	);
+}
+
+/*!
+ * @brief mark a slot as used.
+ *
+ * @param words pointer to the bitmap.
+ * @param i index of the slot.
+ */
+static inline void bitmap_set(bitmap_word *const restrict words, len_ty i)
+{
+	words[i / BITMAP_WORD_BIT] |= (bitmap_word)1 << (i % BITMAP_WORD_BIT);
+}
+
+/*!
+ * @brief mark a slot as unused.
+ *
+ * @param words pointer to the bitmap.
+ * @param i index of the slot.
+ */
+static inline void bitmap_clear(bitmap_word *const restrict words, len_ty i)
+{
+	words[i / BITMAP_WORD_BIT] &= ~((bitmap_word)1 << (i % BITMAP_WORD_BIT));
+}
+
+/*!
+ * @brief position of the highest set bit in a non-zero word.
+ *
+ * @param word the word.
+ * @returns index of the bit.
+ */
+static inline unsigned int bitmap_highest_bit(bitmap_word word)
+{
+#ifdef __GNUC__
+	return (BITMAP_WORD_BIT - 1 - __builtin_clzll(word));
+#else
+	unsigned int n = BITMAP_WORD_BIT - 1;
+
+	for (; !(word >> n); n--)
+		;
+
+	return (n);
+#endif /* __GNUC__ */
+}
+
+/*!
+ * @brief find an unused slot in a range of slots.
+ *
+ * Words are searched downwards from `*hint`, wrapping around to the end of
+ * the range, so consecutive searches pick up from where the last one
+ * stopped instead of going over the same used slots again.
+ *
+ * @param words pointer to the bitmap.
+ * @param first index of the first slot in the range.
+ * @param last index one past the last slot in the range.
+ * @param hint address of the word to start from, updated to the word of the
+ * slot found.
+ * @returns index of an unused slot, -1 if the range has none.
+ */
+static inline len_ty bitmap_find_clear(
+	const bitmap_word *const restrict words, const len_ty first,
+	const len_ty last, len_ty *const restrict hint
+)
+{
+	if (first >= last)
+		return (-1);
+
+	const len_ty first_word = first / BITMAP_WORD_BIT;
+	const len_ty last_word = (last - 1) / BITMAP_WORD_BIT;
+	len_ty w = *hint;
+
+	if (w < first_word || w > last_word)
+		w = last_word;
+
+	for (len_ty n = last_word - first_word + 1; n > 0; n--)
+	{
+		bitmap_word clear = ~words[w];
+
+		/* Mask out the slots outside the range. */
+		if (w == first_word)
+			clear &= ~(bitmap_word)0 << (first % BITMAP_WORD_BIT);
+
+		if (w == last_word && last % BITMAP_WORD_BIT)
+			clear &= ~(~(bitmap_word)0 << (last % BITMAP_WORD_BIT));
+
+		if (clear)
+		{
+			*hint = w;
+			return (w * BITMAP_WORD_BIT + bitmap_highest_bit(clear));
+		}
+
+		w = w > first_word ? w - 1 : last_word;
+	}
+
+	return (-1);
+}
+
+#endif /* HASHMAP_OCCUPANCY_BITMAP */
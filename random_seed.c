@@ -0,0 +1,56 @@
+#ifndef HASHMAP_RANDOM_SEED
+#define HASHMAP_RANDOM_SEED
+
+/*
+ * Seeds for the hash functions of HashMaps.
+ *
+ * Not cryptographically random, but unpredictable enough from outside the
+ * process that colliding keys can not be prepared in advance: the clocks,
+ * addresses randomised by ASLR and a counter are mixed together.
+ */
+
+#include <stdint.h> /* uint64_t, uintptr_t */
+#include <time.h>   /* clock, time */
+
+#ifndef __STDC_NO_ATOMICS__
+	#include <stdatomic.h>
+#endif /* __STDC_NO_ATOMICS__ */
+
+/*! @brief SplitMix64 finaliser, every input bit affects every output bit. */
+static inline uint64_t seed_mix(uint64_t x)
+{
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9ULL;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebULL;
+	x ^= x >> 31;
+	return (x);
+}
+
+/*!
+ * @brief generate a new seed.
+ *
+ * @param salt an address to mix into the seed, such as the HashMap the seed
+ * is for.
+ * @returns the seed.
+ */
+static uint64_t random_seed(const void *const salt)
+{
+#ifndef __STDC_NO_ATOMICS__
+	static atomic_uint_fast64_t counter;
+	const uint64_t count =
+		atomic_fetch_add(&counter, 0x9e3779b97f4a7c15ULL);
+#else
+	static uint64_t counter;
+	const uint64_t count = counter += 0x9e3779b97f4a7c15ULL;
+#endif /* __STDC_NO_ATOMICS__ */
+	const unsigned char stack = 0;
+	uint64_t seed = seed_mix(count ^ (uint64_t)time(NULL));
+
+	seed = seed_mix(seed ^ (uint64_t)clock());
+	seed = seed_mix(seed ^ (uint64_t)(uintptr_t)salt);
+	seed = seed_mix(seed ^ (uint64_t)(uintptr_t)&stack);
+	return (seed_mix(seed ^ (uint64_t)(uintptr_t)&random_seed));
+}
+
+#endif /* HASHMAP_RANDOM_SEED */
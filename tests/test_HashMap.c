@@ -1,7 +1,10 @@
 #include <limits.h>
-#include <string.h> /* memset */
+#include <stdio.h>   /* snprintf */
+#include <string.h>  /* memset */
+#include <threads.h> /* thrd_create */
 
 #include "HashMap.h"
+#include "xalloc/xalloc.h"
 #include "tau/tau.h"
 
 TAU_MAIN()
@@ -64,6 +67,189 @@ TEST_F(hashmap_creation, test_cellar_is_initialised)
 #endif /* CELLAR_COALESCED_HASHING */
 }
 
+TEST_F(hashmap_creation, test_from_pairs)
+{
+	/* Enough keys for 4 threads, each key twice. */
+	enum { count = HASHMAP_GROW_THREAD_SLOTS * 8 };
+	static int ids[count], values[count];
+	static u8mem keys[count];
+
+	for (int i = 0; i < count; i++)
+	{
+		ids[i] = i % (count / 2);
+		values[i] = i;
+		keys[i] =
+			(u8mem){.len = sizeof(ids[i]), .buf = (unsigned char *)&ids[i]};
+	}
+
+	CHECK_PTR_EQ(hm_int_from_pairs(NULL, values, count, 4), NULL);
+	CHECK_PTR_EQ(hm_int_from_pairs(keys, values, -1, 4), NULL);
+	CHECK_PTR_EQ(hm_int_from_pairs(keys, values, count, 0), NULL);
+	keys[count - 1].len = 0;
+	CHECK_PTR_EQ(hm_int_from_pairs(keys, values, count, 4), NULL);
+	keys[count - 1].len = sizeof(ids[count - 1]);
+
+	/* Few keys are inserted by the calling thread alone. */
+	const len_ty sizes[] = {3, count};
+
+	for (size_t s = 0; s < sizeof(sizes) / sizeof(*sizes); s++)
+	{
+		const len_ty n = sizes[s];
+
+		tau->output = hm_int_delete(tau->output, NULL);
+		tau->output = hm_int_from_pairs(keys, values, n, 4);
+		REQUIRE_PTR_NE(tau->output, NULL);
+
+		len_ty used = tau->output->used;
+
+#ifdef CELLAR_COALESCED_HASHING
+		used += tau->output->cellar.used;
+#endif /* CELLAR_COALESCED_HASHING */
+		CHECK(used == (n < count / 2 ? n : count / 2));
+		for (len_ty i = 0; i < n; i++)
+		{
+			const int *const data = hm_int_search(tau->output, keys[i]);
+
+			REQUIRE_PTR_NE(data, NULL);
+			/* The last value of a key wins. */
+			CHECK(*data == (i + count / 2 < n ? i + count / 2 : i));
+		}
+	}
+}
+
+TEST(hashmap_creation, test_huge_table)
+{
+	const len_ty capacity =
+		(len_ty)(HASHMAP_HUGE_PAGES_THRESHOLD / sizeof(Bucket_huge)) + 1;
+	const size_t mapped = pages_mapped();
+	HashMap_huge *restrict hm = hm_huge_new(capacity);
+
+	REQUIRE_PTR_NE(hm, NULL);
+	CHECK(hm->used == 0);
+#ifdef __unix__
+	/* The table was mapped by `pages_alloc` rather than allocated. */
+	CHECK(pages_mapped() >= mapped + HASHMAP_HUGE_PAGES_THRESHOLD);
+#endif /* __unix__ */
+	/* memory checkers should not complain */
+	hm->arr[hm->capacity - 1].hash = 69;
+
+	for (int i = 0; i < 1000; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+
+		REQUIRE_PTR_NE(hm_huge_insert(&hm, key, i), NULL);
+	}
+
+	for (int i = 0; i < 1000; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+		const int *const data = hm_huge_search(hm, key);
+
+		REQUIRE_PTR_NE(data, NULL);
+		CHECK(*data == i);
+	}
+
+	hm = hm_huge_delete(hm, NULL);
+	CHECK(pages_mapped() == mapped);
+}
+
+/*!
+ * @brief insert keys of every length up to that of `mem`, grow, copy and
+ * remove half of them again.
+ */
+static HashMap_int *use_allocated_map(HashMap_int *restrict hm)
+{
+	static unsigned char mem[] = "a key that is too long to be stored inline";
+	HashMap_int *restrict cpy = NULL;
+
+	for (len_ty len = 1; hm && len < (len_ty)sizeof(mem); len++)
+	{
+		if (!hm_int_insert(&hm, (u8mem){.len = len, .buf = mem}, len))
+			return (hm);
+	}
+
+	hm = hm_int_grow(hm, 256);
+	cpy = hm_int_copy(hm, NULL, NULL);
+	for (len_ty len = 1; cpy && len < (len_ty)sizeof(mem); len += 2)
+		hm_int_remove(hm, NULL, (u8mem){.len = len, .buf = mem});
+
+	for (len_ty len = 1; cpy && len < (len_ty)sizeof(mem); len++)
+	{
+		const int *const data =
+			hm_int_search(len % 2 ? cpy : hm, (u8mem){.len = len, .buf = mem});
+
+		if (!data || *data != len)
+			cpy = hm_int_delete(cpy, NULL);
+	}
+
+	hm_int_delete(hm, NULL);
+	return (cpy);
+}
+
+TEST(hashmap_creation, test_arena_allocator)
+{
+	arena *const restrict a = arena_new(512);
+
+	REQUIRE_PTR_NE(a, NULL);
+
+	const allocator alloc = arena_allocator(a);
+	HashMap_int *restrict hm =
+		use_allocated_map(hm_int_new_with_allocator(8, &alloc));
+
+	REQUIRE_PTR_NE(hm, NULL);
+	CHECK_PTR_EQ(hm->alloc, &alloc);
+	/* The keys and Buckets are freed with the arena. */
+	hm_int_delete(hm, NULL);
+	arena_delete(a);
+}
+
+/*! @brief a `pool` that counts the bytes it has handed out. */
+struct counted_pool
+{
+	allocator pool;
+	len_ty bytes;
+};
+
+static void *counted_alloc(void *const ctx, const len_ty size)
+{
+	struct counted_pool *const restrict c = ctx;
+	void *const restrict ptr = c->pool.alloc(c->pool.ctx, size);
+
+	if (ptr)
+		c->bytes += size;
+
+	return (ptr);
+}
+
+static void counted_release(void *const ctx, void *const ptr, const len_ty size)
+{
+	struct counted_pool *const restrict c = ctx;
+
+	c->bytes -= size;
+	c->pool.release(c->pool.ctx, ptr, size);
+}
+
+TEST(hashmap_creation, test_pool_allocator)
+{
+	pool *const restrict p = pool_new(64, 16);
+
+	REQUIRE_PTR_NE(p, NULL);
+
+	struct counted_pool counted = {.pool = pool_allocator(p)};
+	const allocator alloc = {
+		.alloc = counted_alloc, .release = counted_release, .ctx = &counted
+	};
+	HashMap_int *restrict hm =
+		use_allocated_map(hm_int_new_with_allocator(8, &alloc));
+
+	REQUIRE_PTR_NE(hm, NULL);
+	CHECK(counted.bytes > 0);
+	hm_int_delete(hm, NULL);
+	/* Every key and Bucket array went back with the size it was given. */
+	CHECK(counted.bytes == 0);
+	pool_delete(p);
+}
+
 // TEST_F(hashmap_creation, test_capacity_at_limit)
 // {
 // 	const len_ty capacity = LEN_TY_max - sizeof(HashMap) -
@@ -82,35 +268,176 @@ TEST_F(hashmap_creation, test_cellar_is_initialised)
 /*########################## hashing ################################*/
 /*###################################################################*/
 
-TEST(hashing, test_invalid_inputs)
+struct hashing
+{
+	HashMap_int *restrict map;
+};
+
+TEST_F_SETUP(hashing)
+{
+	tau->map = hm_int_new(16);
+	REQUIRE_PTR_NE(tau->map, NULL);
+}
+
+TEST_F_TEARDOWN(hashing) { tau->map = hm_int_delete(tau->map, NULL); }
+
+TEST_F(hashing, test_invalid_inputs)
 {
 	hash_ty hash;
 
 	/* clang-format off */
-	CHECK(hm_int_hash(NULL, (u8mem){.len = -1, .buf = NULL}) == false);
-	CHECK(hm_int_hash(NULL, (u8mem){.len = -1, .buf = (unsigned char *)1}) == false);
-	CHECK(hm_int_hash(NULL, (u8mem){.len = 1, .buf = NULL}) == false);
-	CHECK(hm_int_hash(NULL, (u8mem){.len = 1, .buf = (unsigned char *)1}) == false);
-	CHECK(hm_int_hash(&hash, (u8mem){.len = -1, .buf = (unsigned char *)1}) == false);
-	CHECK(hm_int_hash(&hash, (u8mem){.len = 0, .buf = (unsigned char *)1}) == false);
-	CHECK(hm_int_hash(&hash, (u8mem){.len = 1, .buf = NULL}) == false);
-	CHECK(hm_int_hash(&hash, (u8mem){.len = 0, .buf = NULL}) == false);
-	CHECK(hm_int_hash(&hash, (u8mem){.len = -1, .buf = NULL}) == false);
+	CHECK(hm_int_hash(tau->map, NULL, (u8mem){.len = -1, .buf = NULL}) == false);
+	CHECK(hm_int_hash(tau->map, NULL, (u8mem){.len = -1, .buf = (unsigned char *)1}) == false);
+	CHECK(hm_int_hash(tau->map, NULL, (u8mem){.len = 1, .buf = NULL}) == false);
+	CHECK(hm_int_hash(tau->map, NULL, (u8mem){.len = 1, .buf = (unsigned char *)1}) == false);
+	CHECK(hm_int_hash(tau->map, &hash, (u8mem){.len = -1, .buf = (unsigned char *)1}) == false);
+	CHECK(hm_int_hash(tau->map, &hash, (u8mem){.len = 0, .buf = (unsigned char *)1}) == false);
+	CHECK(hm_int_hash(tau->map, &hash, (u8mem){.len = 1, .buf = NULL}) == false);
+	CHECK(hm_int_hash(tau->map, &hash, (u8mem){.len = 0, .buf = NULL}) == false);
+	CHECK(hm_int_hash(tau->map, &hash, (u8mem){.len = -1, .buf = NULL}) == false);
+	CHECK(hm_int_hash(NULL, &hash, (u8mem){.len = 1, .buf = (unsigned char *)1}) == false);
 	/* clang-format on */
 }
 
-TEST(hashing, test_same_input_same_output)
+TEST_F(hashing, test_same_input_same_output)
 {
 	unsigned char mem[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 123};
 	hash_ty h1, h2;
 
 	/* clang-format off */
-	REQUIRE(hm_int_hash(&h1, (u8mem){.len=sizeof(mem)/sizeof(*mem), .buf=mem}) == true);
-	REQUIRE(hm_int_hash(&h2, (u8mem){.len=sizeof(mem)/sizeof(*mem), .buf=mem}) == true);
+	REQUIRE(hm_int_hash(tau->map, &h1, (u8mem){.len=sizeof(mem)/sizeof(*mem), .buf=mem}) == true);
+	REQUIRE(hm_int_hash(tau->map, &h2, (u8mem){.len=sizeof(mem)/sizeof(*mem), .buf=mem}) == true);
 	/* clang-format on */
 	CHECK(h1 == h2);
 }
 
+TEST_F(hashing, test_seeds_differ)
+{
+	HashMap_int *restrict other = hm_int_new(16);
+
+	REQUIRE_PTR_NE(other, NULL);
+	CHECK(tau->map->seed != other->seed);
+	hm_int_delete(other, NULL);
+}
+
+TEST_F(hashing, test_shared_seed)
+{
+	HashMap_int *restrict other = hm_int_new_seeded(16, tau->map->seed);
+	unsigned char mem[] = "shared";
+	const u8mem key = {.len = sizeof(mem) - 1, .buf = mem};
+	hash_ty h1, h2;
+
+	REQUIRE_PTR_NE(other, NULL);
+	CHECK(other->seed == tau->map->seed);
+	REQUIRE(hm_int_hash(tau->map, &h1, key) == true);
+	REQUIRE(hm_int_hash(other, &h2, key) == true);
+	CHECK(h1 == h2);
+	/* A hash from one map is valid for the other. */
+	REQUIRE_PTR_NE(hm_int_insert_hashed(&other, h1, key, 7), NULL);
+	REQUIRE_PTR_NE(hm_int_search_hashed(other, h1, key), NULL);
+	CHECK(*hm_int_search_hashed(other, h1, key) == 7);
+	hm_int_delete(other, NULL);
+}
+
+TEST_F(hashing, test_known_output)
+{
+	unsigned char mem[] = "hello";
+	hash_ty hash;
+
+	tau->map->seed = 0;
+	REQUIRE(
+		hm_int_hash(tau->map, &hash, (u8mem){.len = 5, .buf = mem}) == true
+	);
+#if defined RUNTIME_HASH_FUNC
+	/* The hash function depends on the CPU, so only check that it mixes. */
+	hash_ty other;
+
+	mem[4] = 'p';
+	REQUIRE(
+		hm_int_hash(tau->map, &other, (u8mem){.len = 5, .buf = mem}) == true
+	);
+	CHECK(hash != other);
+#elif defined WYHASH_HASH_FUNC
+	/* 32 bit hashes keep the low half of the 64 bit hash. */
+	CHECK(hash == (hash_ty)0x49a593f92a7c549fULL);
+#elif defined FNV32A_HASH_FUNC && defined HASHMAP_64BIT_HASH
+	CHECK(sizeof(hash_ty) == 8);
+	CHECK(hash == 0xa430d84680aabd0bULL);
+#elif defined FNV32A_HASH_FUNC
+	CHECK(sizeof(hash_ty) == 4);
+	CHECK(hash == 0x4f9f2cabU);
+#elif defined HASHMAP_64BIT_HASH
+	/* First half of the 128 bit MurmurHash3 x64 hash. */
+	CHECK(sizeof(hash_ty) == 8);
+	CHECK(hash == 0xcbd8a7b341bd9b02ULL);
+#else
+	CHECK(sizeof(hash_ty) == 4);
+	CHECK(hash == 0x248bfa47U);
+#endif /* defined RUNTIME_HASH_FUNC */
+}
+
+#include "aeshash.c"
+#include "wyhash.c"
+
+/* Messages and hashes from the test vectors of wyhash, seeded with i. */
+static const char *const hash_vector_msgs[] = {
+	"",
+	"a",
+	"abc",
+	"message digest",
+	"abcdefghijklmnopqrstuvwxyz",
+	"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789",
+	"123456789012345678901234567890123456789012345678901234567890123456789"
+	"01234567890",
+};
+
+TEST(hashing, test_wyhash_known_output)
+{
+	static const uint64_t expected[] = {
+		0x93228a4de0eec5a2ULL, 0xc5bac3db178713c4ULL, 0xa97f2f7b1d9b3314ULL,
+		0x786d1f1df3801df4ULL, 0xdca5a8138ad37c87ULL, 0xb9e734f117cfaf70ULL,
+		0x6cc5eab49a92d617ULL,
+	};
+
+	for (size_t i = 0; i < sizeof(expected) / sizeof(*expected); i++)
+	{
+		uint64_t hash = i;
+
+		wyhash(
+			(const unsigned char *)hash_vector_msgs[i],
+			strlen(hash_vector_msgs[i]), &hash
+		);
+		CHECK(hash == expected[i]);
+	}
+}
+
+TEST(hashing, test_aes_hash_known_output)
+{
+#ifdef AES_ROUND_HASH_SUPPORTED
+	/* Any change to these breaks hashes kept by callers. */
+	static const uint64_t expected[] = {
+		0xbf1cdc97aec940c5ULL, 0xb20b5c277b67e5e1ULL, 0x8c54d566d6ade326ULL,
+		0xef1cf0b4651dc504ULL, 0x9e949c3b25cadd63ULL, 0x7eca05dae24e2252ULL,
+		0x487245d9903f980aULL,
+	};
+
+	__builtin_cpu_init();
+	if (!__builtin_cpu_supports("aes"))
+		return;
+
+	for (size_t i = 0; i < sizeof(expected) / sizeof(*expected); i++)
+	{
+		uint64_t hash = i;
+
+		aes_hash(
+			(const unsigned char *)hash_vector_msgs[i],
+			strlen(hash_vector_msgs[i]), &hash
+		);
+		CHECK(hash == expected[i]);
+	}
+#endif /* AES_ROUND_HASH_SUPPORTED */
+}
+
 /*###################################################################*/
 /*######################## hashmap_searching ########################*/
 /*###################################################################*/
@@ -187,3 +514,1409 @@ TEST_F(expanding, test_growing_a_hashmap)
 	CHECK(tau->input->cellar.capacity >= initial_cellar_capacity * 2);
 #endif /* CELLAR_COALESCED_HASHING */
 }
+
+TEST_F(expanding, test_growing_in_parallel)
+{
+	CHECK_PTR_EQ(hm_int_grow_parallel(NULL, 32, 4), NULL);
+	CHECK_PTR_EQ(hm_int_grow_parallel(tau->input, 32, 0), NULL);
+	CHECK_PTR_EQ(
+		hm_int_grow_parallel(tau->input, 32, HASHMAP_MAX_GROW_THREADS + 1), NULL
+	);
+	CHECK_PTR_EQ(hm_int_grow_parallel(tau->input, 8, 4), tau->input);
+
+	/* Enough slots for 4 threads. */
+	const int keys = HASHMAP_GROW_THREAD_SLOTS * 4;
+
+	for (int i = 0; i < keys; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+
+		REQUIRE_PTR_NE(hm_int_insert(&tau->input, key, i), NULL);
+	}
+
+	const len_ty capacity = tau->input->capacity;
+	HashMap_int *const restrict grown =
+		hm_int_grow_parallel(tau->input, capacity * 2, 4);
+
+	REQUIRE_PTR_NE(grown, NULL);
+	tau->input = grown;
+	CHECK(tau->input->capacity >= capacity * 2);
+	for (int i = 0; i <= keys; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+		const int *const data = hm_int_search(tau->input, key);
+
+		if (i == keys)
+			CHECK_PTR_EQ(data, NULL);
+		else
+		{
+			REQUIRE_PTR_NE(data, NULL);
+			CHECK(*data == i);
+		}
+	}
+}
+
+TEST(expanding, test_no_shrinking)
+{
+	HashMap_int input = {.capacity = 8};
+
+	CHECK_PTR_EQ(hm_int_shrink(NULL, 1), NULL);
+	CHECK_PTR_EQ(hm_int_shrink(&input, 0), NULL);
+	CHECK_PTR_EQ(hm_int_shrink(&input, input.capacity), &input);
+	CHECK_PTR_EQ(hm_int_shrink(&input, input.capacity * 2), &input);
+	CHECK_PTR_EQ(hm_int_trim(NULL), NULL);
+	CHECK_PTR_EQ(hm_int_trim(&input), &input);
+}
+
+TEST_F(expanding, test_shrinking_a_hashmap)
+{
+	const int keys = 1000;
+
+	for (int i = 0; i < keys; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+
+		REQUIRE_PTR_NE(hm_int_insert(&tau->input, key, i), NULL);
+	}
+
+	/* Half full, nothing to trim. */
+	for (int i = 0; i < keys / 2; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+
+		REQUIRE(hm_int_remove(tau->input, NULL, key));
+	}
+
+	const len_ty capacity = tau->input->capacity;
+
+	CHECK_PTR_EQ(hm_int_trim(tau->input), tau->input);
+	for (int i = keys / 2; i < keys - 20; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+
+		REQUIRE(hm_int_remove(tau->input, NULL, key));
+	}
+
+	HashMap_int *restrict output = hm_int_trim(tau->input);
+
+	REQUIRE_PTR_NE(output, NULL);
+	tau->input = output;
+	CHECK(tau->input->capacity < capacity);
+	CHECK(tau->input->capacity >= HASHMAP_MIN_TRIM_CAPACITY);
+	/* Trimmed maps are not trimmed again right away. */
+	CHECK_PTR_EQ(hm_int_trim(tau->input), tau->input);
+
+	/* Never below what the keys need. */
+	output = hm_int_shrink(tau->input, 1);
+	REQUIRE_PTR_NE(output, NULL);
+	tau->input = output;
+	CHECK(tau->input->capacity >= 20 / HASHMAP_MAX_LOAD_FACTOR);
+	CHECK(tau->input->capacity < HASHMAP_MIN_TRIM_CAPACITY);
+	for (int i = 0; i < keys; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+		const int *const data = hm_int_search(tau->input, key);
+
+		if (i < keys - 20)
+			CHECK_PTR_EQ(data, NULL);
+		else
+		{
+			REQUIRE_PTR_NE(data, NULL);
+			CHECK(*data == i);
+		}
+	}
+}
+
+/*###################################################################*/
+/*############################ modifying ############################*/
+/*###################################################################*/
+
+struct modifying
+{
+	HashMap_int *restrict map;
+};
+
+TEST_F_SETUP(modifying)
+{
+	tau->map = hm_int_new(7);
+	REQUIRE_PTR_NE(tau->map, NULL);
+}
+
+TEST_F_TEARDOWN(modifying) { tau->map = hm_int_delete(tau->map, NULL); }
+
+TEST_F(modifying, test_overwriting_a_key)
+{
+	unsigned char mem[] = "key";
+	const u8mem key = {.len = sizeof(mem) - 1, .buf = mem};
+	int *const restrict first = hm_int_insert(&tau->map, key, 1);
+
+	REQUIRE_PTR_NE(first, NULL);
+	CHECK_PTR_EQ(hm_int_insert(&tau->map, key, 2), first);
+	CHECK(*first == 2);
+	CHECK(tau->map->used == 1);
+}
+
+TEST_F(modifying, test_short_and_long_keys)
+{
+	unsigned char mem[] = "a key that is too long to be stored in a Bucket";
+
+	for (len_ty len = 1; len < (len_ty)sizeof(mem); len++)
+	{
+		const u8mem key = {.len = len, .buf = mem};
+
+		REQUIRE_PTR_NE(hm_int_insert(&tau->map, key, len), NULL);
+	}
+
+	for (len_ty len = 1; len < (len_ty)sizeof(mem); len++)
+	{
+		const u8mem key = {.len = len, .buf = mem};
+		const int *const restrict found = hm_int_search(tau->map, key);
+		int data = -1;
+
+		REQUIRE_PTR_NE(found, NULL);
+		CHECK(*found == len);
+		CHECK(hm_int_remove(tau->map, &data, key) == true);
+		CHECK(data == len);
+	}
+
+	CHECK(tau->map->used == 0);
+}
+
+TEST_F(modifying, test_insert_search_remove)
+{
+	const int count = 500;
+
+	for (int i = 0; i < count; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+
+		REQUIRE_PTR_NE(hm_int_insert(&tau->map, key, i), NULL);
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+		const int *const restrict data = hm_int_search(tau->map, key);
+
+		REQUIRE_PTR_NE(data, NULL);
+		CHECK(*data == i);
+	}
+
+	for (int i = 0; i < count; i += 2)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+		int data = -1;
+
+		CHECK(hm_int_remove(tau->map, &data, key) == true);
+		CHECK(data == i);
+		CHECK(hm_int_remove(tau->map, &data, key) == false);
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+		const int *const restrict data = hm_int_search(tau->map, key);
+
+		if (i % 2)
+			CHECK_PTR_NE(data, NULL);
+		else
+			CHECK_PTR_EQ(data, NULL);
+	}
+}
+
+TEST_F(modifying, test_copy)
+{
+	const int count = 100;
+
+	for (int i = 0; i < count; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+
+		REQUIRE_PTR_NE(hm_int_insert(&tau->map, key, i), NULL);
+	}
+
+	HashMap_int *restrict cpy = hm_int_copy(tau->map, NULL, NULL);
+
+	REQUIRE_PTR_NE(cpy, NULL);
+	CHECK(cpy->used == tau->map->used);
+#ifdef CELLAR_COALESCED_HASHING
+	CHECK(cpy->cellar.used == tau->map->cellar.used);
+#endif /* CELLAR_COALESCED_HASHING */
+
+	/* The copy keeps working once it is modified. */
+	for (int i = 0; i < count; i += 2)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+
+		CHECK(hm_int_remove(cpy, NULL, key) == true);
+	}
+
+	for (int i = count; i < count * 2; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+
+		REQUIRE_PTR_NE(hm_int_insert(&cpy, key, i), NULL);
+	}
+
+	for (int i = 0; i < count * 2; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+		const int *const restrict data = hm_int_search(cpy, key);
+
+		if (i < count && i % 2 == 0)
+			CHECK_PTR_EQ(data, NULL);
+		else
+		{
+			REQUIRE_PTR_NE(data, NULL);
+			CHECK(*data == i);
+		}
+
+		/* The original is left as it was. */
+		if (i < count)
+			CHECK_PTR_NE(hm_int_search(tau->map, key), NULL);
+	}
+
+	hm_int_delete(cpy, NULL);
+}
+
+TEST_F(modifying, test_remove_from_coalesced_chains)
+{
+	enum { count = 1000 };
+
+	for (int i = 0; i < count; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+
+		REQUIRE_PTR_NE(hm_int_insert(&tau->map, key, i), NULL);
+	}
+
+	/* Chains share slots, remove in an order unrelated to insertion. */
+	for (int n = 0; n < count / 2; n++)
+	{
+		const int i = (n * 7919) % count;
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+
+		REQUIRE(hm_int_remove(tau->map, NULL, key) == true);
+	}
+
+	for (int n = 0; n < count; n++)
+	{
+		const int i = (n * 7919) % count;
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+		const int *const restrict data = hm_int_search(tau->map, key);
+
+		if (n < count / 2)
+			CHECK_PTR_EQ(data, NULL);
+		else
+		{
+			REQUIRE_PTR_NE(data, NULL);
+			CHECK(*data == i);
+		}
+	}
+}
+
+TEST_F(modifying, test_hashed_operations)
+{
+	unsigned char mem[] = "identifier";
+	const u8mem key = {.len = sizeof(mem) - 1, .buf = mem};
+	hash_ty hash;
+	int data = -1;
+
+	REQUIRE(hm_int_hash(tau->map, &hash, key) == true);
+	REQUIRE_PTR_NE(hm_int_insert_hashed(&tau->map, hash, key, 7), NULL);
+
+	const int *const restrict found = hm_int_search(tau->map, key);
+
+	REQUIRE_PTR_NE(found, NULL);
+	CHECK(*found == 7);
+	CHECK_PTR_EQ(hm_int_search_hashed(tau->map, hash, key), found);
+	CHECK_PTR_EQ(hm_int_search_hashed(tau->map, hash, (u8mem){0}), NULL);
+	CHECK_PTR_EQ(hm_int_insert_hashed(&tau->map, hash, (u8mem){0}, 1), NULL);
+	CHECK(hm_int_remove_hashed(tau->map, &data, hash, key) == true);
+	CHECK(data == 7);
+	CHECK(hm_int_remove_hashed(tau->map, &data, hash, key) == false);
+	CHECK_PTR_EQ(hm_int_search(tau->map, key), NULL);
+}
+
+#if !defined SWISS_TABLE_PROBING && !defined ROBIN_HOOD_HASHING &&           \
+	!defined EMPTY_BUCKET_STACK
+	#include "occupancy_bitmap.c"
+
+/*!
+ * @brief check that the occupancy bitmap of a HashMap marks exactly its
+ * live Buckets.
+ */
+static bool bitmap_matches(HashMap_int *const hm)
+{
+	len_ty slots = hm->capacity;
+
+	#ifdef CELLAR_COALESCED_HASHING
+	slots += hm->cellar.capacity;
+	#endif /* CELLAR_COALESCED_HASHING */
+	/* The bitmap is stored after the Buckets and the Links. */
+	#ifdef HOT_COLD_SPLIT
+	const bitmap_word *const words =
+		bitmap_align((unsigned char *)((Link_int *)&hm->arr[slots] + slots));
+	#else
+	const bitmap_word *const words =
+		bitmap_align((unsigned char *)&hm->arr[slots]);
+	#endif /* HOT_COLD_SPLIT */
+
+	for (len_ty i = 0; i < slots; i++)
+	{
+		const bool bit =
+			(words[i / BITMAP_WORD_BIT] >> (i % BITMAP_WORD_BIT)) & 1;
+
+		if (bit != (hm->arr[i].key_len > 0))
+			return (false);
+	}
+
+	#ifdef INCREMENTAL_RESIZE
+	if (hm->old)
+		return (bitmap_matches(hm->old));
+
+	#endif /* INCREMENTAL_RESIZE */
+	return (true);
+}
+
+TEST_F(modifying, test_occupancy_bitmap)
+{
+	const int count = 300;
+
+	for (int i = 0; i < count; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+
+		REQUIRE_PTR_NE(hm_int_insert(&tau->map, key, i), NULL);
+	}
+
+	CHECK(bitmap_matches(tau->map));
+	for (int i = 0; i < count; i += 3)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+
+		REQUIRE(hm_int_remove(tau->map, NULL, key) == true);
+	}
+
+	CHECK(bitmap_matches(tau->map));
+	/* Removed slots are found again. */
+	for (int i = 0; i < count; i += 3)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+
+		REQUIRE_PTR_NE(hm_int_insert(&tau->map, key, i), NULL);
+	}
+
+	CHECK(bitmap_matches(tau->map));
+	tau->map = hm_int_grow(tau->map, 2048);
+	REQUIRE_PTR_NE(tau->map, NULL);
+	CHECK(bitmap_matches(tau->map));
+}
+#endif /* !defined SWISS_TABLE_PROBING && !defined ROBIN_HOOD_HASHING */
+
+TEST_F(modifying, test_long_chain_reseeds)
+{
+	const int count = 100;
+
+	for (int i = 0; i < count; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+
+		REQUIRE_PTR_NE(hm_int_insert(&tau->map, key, i), NULL);
+	}
+
+	/* As if a search had walked a chain of colliding keys. */
+	unsigned char mem[] = "late";
+	const uint64_t seed = tau->map->seed;
+
+	tau->map->long_chain = true;
+	REQUIRE_PTR_NE(
+		hm_int_insert(&tau->map, (u8mem){.len = 3, .buf = mem}, -1), NULL
+	);
+	CHECK(tau->map->seed != seed);
+	CHECK(tau->map->reseeded == true);
+#ifdef CELLAR_COALESCED_HASHING
+	CHECK(tau->map->used + tau->map->cellar.used == count + 1);
+#else
+	CHECK(tau->map->used == count + 1);
+#endif /* CELLAR_COALESCED_HASHING */
+
+	/* Only once per capacity. */
+	const uint64_t new_seed = tau->map->seed;
+
+	tau->map->long_chain = true;
+	REQUIRE_PTR_NE(
+		hm_int_insert(&tau->map, (u8mem){.len = 4, .buf = mem}, -2), NULL
+	);
+	CHECK(tau->map->seed == new_seed);
+
+	for (int i = 0; i < count; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+		const int *const restrict data = hm_int_search(tau->map, key);
+
+		REQUIRE_PTR_NE(data, NULL);
+		CHECK(*data == i);
+	}
+}
+
+TEST_F(modifying, test_held_hash_survives_long_chain)
+{
+	for (int i = 0; i < 100; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+
+		REQUIRE_PTR_NE(hm_int_insert(&tau->map, key, i), NULL);
+	}
+
+	unsigned char mem[] = "held";
+	const u8mem key = {.len = 4, .buf = mem};
+	const uint64_t seed = tau->map->seed;
+	hash_ty hash;
+
+	REQUIRE(hm_int_hash(tau->map, &hash, key) == true);
+
+	/* The hashed paths leave the seed alone, so `hash` stays valid. */
+	tau->map->long_chain = true;
+	REQUIRE_PTR_NE(hm_int_insert_hashed(&tau->map, hash, key, -1), NULL);
+	CHECK(tau->map->seed == seed);
+	CHECK(tau->map->long_chain == true);
+	CHECK_PTR_NE(hm_int_search_hashed(tau->map, hash, key), NULL);
+
+	/* The next plain insertion reseeds, which the seed shows. */
+	REQUIRE_PTR_NE(
+		hm_int_insert(&tau->map, (u8mem){.len = 3, .buf = mem}, -2), NULL
+	);
+	REQUIRE(tau->map->seed != seed);
+	REQUIRE(hm_int_hash(tau->map, &hash, key) == true);
+
+	const int *const restrict data = hm_int_search_hashed(tau->map, hash, key);
+
+	REQUIRE_PTR_NE(data, NULL);
+	CHECK(*data == -1);
+	CHECK(hm_int_remove_hashed(tau->map, NULL, hash, key) == true);
+}
+
+TEST_F(modifying, test_search_batch)
+{
+	enum { count = 100 };
+	int ints[count];
+	u8mem keys[count];
+	int *out[count];
+
+	for (int i = 0; i < count; i++)
+	{
+		ints[i] = i;
+		keys[i] = (u8mem){
+			.len = sizeof(ints[i]), .buf = (unsigned char *)&ints[i]
+		};
+		if (i % 3)
+			REQUIRE_PTR_NE(hm_int_insert(&tau->map, keys[i], i), NULL);
+	}
+
+	keys[count - 1] = (u8mem){0};
+	REQUIRE(hm_int_search_batch(tau->map, keys, count, out) == true);
+	for (int i = 0; i < count - 1; i++)
+	{
+		if (i % 3)
+		{
+			REQUIRE_PTR_NE(out[i], NULL);
+			CHECK(*out[i] == i);
+		}
+		else
+			CHECK_PTR_EQ(out[i], NULL);
+	}
+
+	CHECK_PTR_EQ(out[count - 1], NULL);
+	CHECK(hm_int_search_batch(tau->map, keys, 0, NULL) == true);
+	CHECK(hm_int_search_batch(NULL, keys, count, out) == false);
+	CHECK(hm_int_search_batch(tau->map, NULL, count, out) == false);
+}
+
+TEST_F(modifying, test_search_batch_during_resize)
+{
+	enum { count = 200 };
+	int ints[count];
+	u8mem keys[count];
+	int *out[count];
+	len_ty inserted = 0;
+
+	for (int i = 0; i < count; i++)
+	{
+		ints[i] = i;
+		keys[i] = (u8mem){
+			.len = sizeof(ints[i]), .buf = (unsigned char *)&ints[i]
+		};
+	}
+
+	/* Stop right after a resize so most Buckets are still in the old map. */
+	while (inserted < count)
+	{
+		const len_ty capacity = tau->map->capacity;
+
+		REQUIRE_PTR_NE(
+			hm_int_insert(&tau->map, keys[inserted], (int)inserted), NULL
+		);
+		inserted++;
+		if (inserted > 2 * HASHMAP_BATCH_GROUP &&
+			tau->map->capacity != capacity)
+			break;
+	}
+
+#ifdef INCREMENTAL_RESIZE
+	REQUIRE_PTR_NE(tau->map->old, NULL);
+#endif /* INCREMENTAL_RESIZE */
+	REQUIRE(hm_int_search_batch(tau->map, keys, inserted, out) == true);
+	for (len_ty i = 0; i < inserted; i++)
+	{
+		REQUIRE_PTR_NE(out[i], NULL);
+		CHECK(*out[i] == i);
+	}
+}
+
+static char *int_tostr(const int data)
+{
+	char *const restrict s = xmalloc(16);
+
+	if (s)
+		snprintf(s, 16, "%d", data);
+
+	return (s);
+}
+
+TEST_F(modifying, test_insert_batch)
+{
+	enum { count = 100 };
+	int ids[count + 1], values[count + 1];
+	u8mem keys[count + 1];
+	bool added[count + 1];
+
+	/* The last key repeats the first. */
+	for (int i = 0; i <= count; i++)
+	{
+		ids[i] = i % count;
+		values[i] = i;
+		keys[i] =
+			(u8mem){.len = sizeof(ids[i]), .buf = (unsigned char *)&ids[i]};
+	}
+
+	REQUIRE_PTR_NE(hm_int_insert(&tau->map, keys[1], -1), NULL);
+	CHECK(hm_int_insert_batch(NULL, keys, values, count, added) == 0);
+	CHECK(hm_int_insert_batch(&tau->map, keys, NULL, count, added) == 0);
+	CHECK(hm_int_insert_batch(&tau->map, keys, values, 0, added) == 0);
+
+	const len_ty capacity = tau->map->capacity;
+
+	CHECK(
+		hm_int_insert_batch(&tau->map, keys, values, count + 1, added) ==
+		count + 1
+	);
+	/* Grown once, straight to a capacity that holds the whole batch. */
+	CHECK(tau->map->capacity >= (count + 1) / HASHMAP_MAX_LOAD_FACTOR);
+	CHECK(tau->map->capacity <= (count + 1) * 2 / HASHMAP_MAX_LOAD_FACTOR);
+	CHECK(tau->map->capacity > capacity);
+	for (int i = 0; i <= count; i++)
+		CHECK(added[i] == (i != 1 && i != count));
+
+	for (int i = 0; i < count; i++)
+	{
+		const int *const restrict data = hm_int_search(tau->map, keys[i]);
+
+		REQUIRE_PTR_NE(data, NULL);
+		CHECK(*data == (i == 0 ? count : i));
+	}
+
+	/* Keys after an invalid one are left out. */
+	keys[count].len = 0;
+	ids[count - 1] = -1;
+	CHECK(
+		hm_int_insert_batch(&tau->map, &keys[count - 1], values, 2, NULL) == 1
+	);
+	CHECK_PTR_NE(hm_int_search(tau->map, keys[count - 1]), NULL);
+}
+
+TEST_F(modifying, test_insert_batch_during_resize)
+{
+	enum { count = 400 };
+	int ids[count];
+	u8mem keys[count];
+	len_ty inserted = 0;
+
+	for (int i = 0; i < count; i++)
+	{
+		ids[i] = i;
+		keys[i] =
+			(u8mem){.len = sizeof(ids[i]), .buf = (unsigned char *)&ids[i]};
+	}
+
+	/* Stop right after a resize so most Buckets are still in the old map. */
+	while (inserted < count / 2)
+	{
+		const len_ty capacity = tau->map->capacity;
+
+		REQUIRE_PTR_NE(
+			hm_int_insert(&tau->map, keys[inserted], ids[inserted]), NULL
+		);
+		inserted++;
+		if (inserted > HASHMAP_BATCH_GROUP && tau->map->capacity != capacity)
+			break;
+	}
+
+	/* A batch as large again only fits if the old Buckets are counted. */
+	REQUIRE(
+		hm_int_insert_batch(
+			&tau->map, &keys[inserted], &ids[inserted], inserted, NULL
+		) == inserted
+	);
+	CHECK(inserted * 2 <= HASHMAP_MAX_LOAD_FACTOR * tau->map->capacity);
+	for (len_ty i = 0; i < inserted * 2; i++)
+	{
+		const int *const restrict data = hm_int_search(tau->map, keys[i]);
+
+		REQUIRE_PTR_NE(data, NULL);
+		CHECK(*data == i);
+	}
+}
+
+TEST_F(modifying, test_memory_usage)
+{
+	enum { count = 200, key_size = sizeof(u8mem) + 20 };
+	unsigned char short_key[] = "a";
+	char mem[32];
+	hm_memory usage;
+
+	CHECK(hm_int_memory_usage(NULL, &usage) == false);
+	CHECK(hm_int_memory_usage(tau->map, NULL) == false);
+	REQUIRE(hm_int_memory_usage(tau->map, &usage));
+	CHECK(usage.keys == 0);
+	CHECK(usage.per_key == 0);
+	CHECK(usage.table > sizeof(*tau->map));
+
+	/* Short keys are stored in the Buckets, long keys on their own. */
+	REQUIRE_PTR_NE(hm_int_insert(&tau->map, (u8mem){1, short_key}, 0), NULL);
+	for (int i = 0; i < count; i++)
+	{
+		snprintf(mem, sizeof(mem), "a key of twenty %4d", i);
+		REQUIRE_PTR_NE(
+			hm_int_insert(&tau->map, (u8mem){20, (unsigned char *)mem}, i),
+			NULL
+		);
+	}
+
+	REQUIRE(hm_int_memory_usage(tau->map, &usage));
+	CHECK(usage.keys == count * key_size);
+	CHECK(
+		usage.total == usage.table + usage.cellar + usage.keys + usage.overhead
+	);
+	CHECK(usage.overhead >= count * HASHMAP_ALLOC_OVERHEAD);
+	CHECK(usage.per_key == (double)usage.total / (count + 1));
+
+	HashMap_int *const restrict cpy = hm_int_copy(tau->map, NULL, NULL);
+	hm_memory cpy_usage;
+
+	REQUIRE_PTR_NE(cpy, NULL);
+	CHECK(hm_int_memory_usage(cpy, &cpy_usage));
+	CHECK(cpy_usage.keys == usage.keys);
+	hm_int_delete(cpy, NULL);
+
+	for (int i = 0; i < count; i += 2)
+	{
+		snprintf(mem, sizeof(mem), "a key of twenty %4d", i);
+		CHECK(hm_int_remove(tau->map, NULL, (u8mem){20, (unsigned char *)mem}));
+	}
+
+	REQUIRE(hm_int_memory_usage(tau->map, &usage));
+	CHECK(usage.keys == count / 2 * key_size);
+}
+
+TEST_F(modifying, test_stringify)
+{
+	char *restrict str = hm_int_tostr(tau->map, int_tostr);
+
+	REQUIRE_PTR_NE(str, NULL);
+	CHECK_STREQ(str, "{}");
+	str = xfree(str);
+
+	unsigned char mem[] = "ab";
+
+	REQUIRE_PTR_NE(hm_int_insert(&tau->map, (u8mem){1, &mem[0]}, 1), NULL);
+	REQUIRE_PTR_NE(hm_int_insert(&tau->map, (u8mem){1, &mem[1]}, 2), NULL);
+	str = hm_int_tostr(tau->map, int_tostr);
+	REQUIRE_PTR_NE(str, NULL);
+	CHECK(str[0] == '{');
+	CHECK(str[strlen(str) - 1] == '}');
+	CHECK_PTR_NE(strstr(str, ": 1"), NULL);
+	CHECK_PTR_NE(strstr(str, ": 2"), NULL);
+	CHECK_PTR_NE(strstr(str, ", "), NULL);
+	xfree(str);
+}
+
+/*###################################################################*/
+/*############################ typed_keys ###########################*/
+/*###################################################################*/
+
+struct typed_keys
+{
+	HashMap_id *restrict map;
+};
+
+TEST_F_SETUP(typed_keys)
+{
+	tau->map = hm_id_new(7);
+	REQUIRE_PTR_NE(tau->map, NULL);
+}
+
+TEST_F_TEARDOWN(typed_keys) { tau->map = hm_id_delete(tau->map, NULL); }
+
+TEST_F(typed_keys, test_insert_search_remove)
+{
+	const int count = 500;
+
+	/* Zero is a valid key, and the keys only differ in their high bits. */
+	for (int i = 0; i < count; i++)
+		REQUIRE_PTR_NE(hm_id_insert(&tau->map, (uint64_t)i << 40, i), NULL);
+
+	for (int i = 0; i < count; i += 2)
+	{
+		int data = -1;
+
+		CHECK(hm_id_remove(tau->map, &data, (uint64_t)i << 40) == true);
+		CHECK(data == i);
+		CHECK(hm_id_remove(tau->map, &data, (uint64_t)i << 40) == false);
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		const int *const restrict data =
+			hm_id_search(tau->map, (uint64_t)i << 40);
+
+		if (i % 2)
+		{
+			REQUIRE_PTR_NE(data, NULL);
+			CHECK(*data == i);
+		}
+		else
+			CHECK_PTR_EQ(data, NULL);
+	}
+}
+
+TEST_F(typed_keys, test_overwrite_and_batch)
+{
+	enum { count = 64 };
+	uint64_t keys[count];
+	int *out[count];
+
+	for (int i = 0; i < count; i++)
+	{
+		keys[i] = UINT64_MAX - (uint64_t)i;
+		if (i % 2)
+			REQUIRE_PTR_NE(hm_id_insert(&tau->map, keys[i], i), NULL);
+	}
+
+	int *const restrict first = hm_id_search(tau->map, keys[1]);
+
+	REQUIRE_PTR_NE(first, NULL);
+#ifdef INCREMENTAL_RESIZE
+	/* The insertion can migrate the Bucket, moving its data. */
+	int *const restrict overwritten = hm_id_insert(&tau->map, keys[1], -1);
+
+	REQUIRE_PTR_NE(overwritten, NULL);
+	CHECK(*overwritten == -1);
+#else
+	CHECK_PTR_EQ(hm_id_insert(&tau->map, keys[1], -1), first);
+	CHECK(*first == -1);
+#endif /* INCREMENTAL_RESIZE */
+	CHECK(*hm_id_search(tau->map, keys[1]) == -1);
+	REQUIRE(hm_id_search_batch(tau->map, keys, count, out) == true);
+	for (int i = 2; i < count; i++)
+	{
+		if (i % 2)
+		{
+			REQUIRE_PTR_NE(out[i], NULL);
+			CHECK(*out[i] == i);
+		}
+		else
+			CHECK_PTR_EQ(out[i], NULL);
+	}
+}
+
+TEST_F(typed_keys, test_stringify)
+{
+	REQUIRE_PTR_NE(hm_id_insert(&tau->map, 0x2a, 1), NULL);
+
+	char *const restrict str = hm_id_tostr(tau->map, int_tostr);
+
+	REQUIRE_PTR_NE(str, NULL);
+	CHECK_PTR_NE(strstr(str, ": 1"), NULL);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	CHECK_STREQ(str, "{0x000000000000002a: 1}");
+#endif /* __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ */
+	xfree(str);
+}
+
+/*###################################################################*/
+/*############################ interning ############################*/
+/*###################################################################*/
+
+struct interning
+{
+	HashMap_sym *restrict map;
+};
+
+TEST_F_SETUP(interning)
+{
+	tau->map = hm_sym_new(7);
+	REQUIRE_PTR_NE(tau->map, NULL);
+}
+
+TEST_F_TEARDOWN(interning) { tau->map = hm_sym_delete(tau->map, NULL); }
+
+TEST_F(interning, test_equal_keys_share_a_handle)
+{
+	unsigned char mem0[] = "identifier", mem1[] = "identifier";
+	const Interned_sym *const restrict handle =
+		hm_sym_intern(&tau->map, (u8mem){sizeof(mem0) - 1, mem0});
+
+	REQUIRE_PTR_NE(handle, NULL);
+	CHECK(handle->key.len == sizeof(mem0) - 1);
+	CHECK_PTR_NE(handle->key.buf, mem0);
+	CHECK_PTR_EQ(
+		hm_sym_intern(&tau->map, (u8mem){sizeof(mem1) - 1, mem1}), handle
+	);
+	CHECK_PTR_EQ(hm_sym_intern(&tau->map, (u8mem){0}), NULL);
+	CHECK(tau->map->used == 1);
+
+	int *const restrict data = hm_sym_search_interned(tau->map, handle);
+
+	REQUIRE_PTR_NE(data, NULL);
+	CHECK(*data == 0);
+	*data = 5;
+	CHECK_PTR_EQ(hm_sym_search(tau->map, handle->key), data);
+	/* Interning the key again leaves its data alone. */
+	CHECK_PTR_EQ(
+		hm_sym_intern(&tau->map, (u8mem){sizeof(mem1) - 1, mem1}), handle
+	);
+	CHECK(*data == 5);
+	CHECK_PTR_EQ(hm_sym_search_interned(tau->map, NULL), NULL);
+}
+
+TEST_F(interning, test_handles_outlive_resizing)
+{
+	enum { count = 300 };
+	const Interned_sym *handles[count];
+
+	for (int i = 0; i < count; i++)
+	{
+		handles[i] = hm_sym_intern(
+			&tau->map, (u8mem){.len = sizeof(i), .buf = (unsigned char *)&i}
+		);
+		REQUIRE_PTR_NE(handles[i], NULL);
+		*hm_sym_search_interned(tau->map, handles[i]) = i;
+	}
+
+	/* A fresh seed changes every hash, the handles must follow. */
+	tau->map->long_chain = true;
+	REQUIRE_PTR_NE(
+		hm_sym_insert(&tau->map, (u8mem){3, (unsigned char *)"new"}, -1), NULL
+	);
+	REQUIRE(tau->map->reseeded == true);
+	for (int i = 0; i < count; i++)
+	{
+		const int *const restrict data =
+			hm_sym_search_interned(tau->map, handles[i]);
+
+		REQUIRE_PTR_NE(data, NULL);
+		CHECK(*data == i);
+		CHECK(*(const int *)handles[i]->key.buf == i);
+	}
+
+	int data = -1;
+
+	REQUIRE(hm_sym_remove(tau->map, &data, handles[0]->key) == true);
+	CHECK(data == 0);
+}
+
+/*###################################################################*/
+/*############################ concurrent ###########################*/
+/*###################################################################*/
+
+struct concurrent
+{
+	ConcurrentHashMap_int *restrict map;
+};
+
+TEST_F_SETUP(concurrent)
+{
+	tau->map = hm_int_concurrent_new(8, 4);
+	REQUIRE_PTR_NE(tau->map, NULL);
+}
+
+TEST_F_TEARDOWN(concurrent)
+{
+	tau->map = hm_int_concurrent_delete(tau->map, NULL);
+}
+
+TEST(concurrent, test_invalid_arguments)
+{
+	CHECK_PTR_EQ(hm_int_concurrent_new(0, 4), NULL);
+	CHECK_PTR_EQ(hm_int_concurrent_new(8, 0), NULL);
+	CHECK_PTR_EQ(hm_int_concurrent_new(8, HASHMAP_MAX_STRIPES + 1), NULL);
+	CHECK(hm_int_concurrent_insert(NULL, (u8mem){0}, 0) == false);
+	CHECK(hm_int_concurrent_used(NULL) == -1);
+}
+
+TEST_F(concurrent, test_stripes)
+{
+	ConcurrentHashMap_int *const restrict map = hm_int_concurrent_new(8, 5);
+
+	REQUIRE_PTR_NE(map, NULL);
+	CHECK(map->stripe_count == 8);
+	CHECK(hm_int_concurrent_capacity(map) == 8);
+	hm_int_concurrent_delete(map, NULL);
+
+	unsigned char mem[] = "key";
+	const u8mem key = {.len = sizeof(mem) - 1, .buf = mem};
+	int data = -1;
+
+	CHECK(hm_int_concurrent_insert(tau->map, (u8mem){0}, 1) == false);
+	REQUIRE(hm_int_concurrent_insert(tau->map, key, 1) == true);
+	REQUIRE(hm_int_concurrent_insert(tau->map, key, 2) == true);
+	CHECK(hm_int_concurrent_used(tau->map) == 1);
+	CHECK(hm_int_concurrent_search(tau->map, &data, key) == true);
+	CHECK(data == 2);
+	CHECK(hm_int_concurrent_remove(tau->map, NULL, key) == true);
+	CHECK(hm_int_concurrent_search(tau->map, NULL, key) == false);
+}
+
+TEST_F(concurrent, test_stripes_grow_together)
+{
+	ConcurrentHashMap_int *const restrict map = tau->map;
+
+	for (int i = 0; i < 500; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+
+		REQUIRE(hm_int_concurrent_insert(map, key, i) == true);
+	}
+
+	const len_ty capacity = hm_int_concurrent_capacity(map);
+
+	for (len_ty s = 1; s < map->stripe_count; s++)
+		CHECK(map->stripes[s].map->capacity == map->stripes[0].map->capacity);
+
+	/* Overwriting a key does not grow the stripes. */
+	for (int i = 0; i < 500; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+
+		REQUIRE(hm_int_concurrent_insert(map, key, -i) == true);
+	}
+
+	CHECK(hm_int_concurrent_capacity(map) == capacity);
+	CHECK(hm_int_concurrent_used(map) == 500);
+}
+
+enum
+{
+	THREAD_COUNT = 4,
+	THREAD_KEYS = 1000
+};
+
+/*! @brief arguments of a thread using a concurrent or sharded HashMap. */
+struct worker
+{
+	void *map;
+	int first;
+	int errors;
+};
+
+static int concurrent_worker(void *arg)
+{
+	struct worker *const w = arg;
+
+	for (int i = w->first; i < w->first + THREAD_KEYS; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+
+		if (!hm_int_concurrent_insert(w->map, key, i))
+			w->errors++;
+	}
+
+	for (int i = w->first; i < w->first + THREAD_KEYS; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+		int data = -1;
+
+		if (!hm_int_concurrent_search(w->map, &data, key) || data != i)
+			w->errors++;
+
+		if (i % 2 && !hm_int_concurrent_remove(w->map, NULL, key))
+			w->errors++;
+	}
+
+	return (0);
+}
+
+TEST_F(concurrent, test_parallel_operations)
+{
+	thrd_t threads[THREAD_COUNT];
+	struct worker workers[THREAD_COUNT];
+
+	for (int t = 0; t < THREAD_COUNT; t++)
+	{
+		workers[t] = (struct worker){tau->map, t * THREAD_KEYS, 0};
+		REQUIRE(
+			thrd_create(&threads[t], concurrent_worker, &workers[t]) ==
+			thrd_success
+		);
+	}
+
+	for (int t = 0; t < THREAD_COUNT; t++)
+	{
+		REQUIRE(thrd_join(threads[t], NULL) == thrd_success);
+		CHECK(workers[t].errors == 0);
+	}
+
+	CHECK(hm_int_concurrent_used(tau->map) == THREAD_COUNT * THREAD_KEYS / 2);
+	CHECK(hm_int_concurrent_capacity(tau->map) > 8);
+	for (int i = 0; i < THREAD_COUNT * THREAD_KEYS; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+
+		CHECK(hm_int_concurrent_search(tau->map, NULL, key) == !(i % 2));
+	}
+}
+
+/*###################################################################*/
+/*############################# sharded #############################*/
+/*###################################################################*/
+
+struct sharded
+{
+	ShardedHashMap_int *restrict map;
+};
+
+TEST_F_SETUP(sharded)
+{
+	tau->map = hm_int_sharded_new(8, 2);
+	REQUIRE_PTR_NE(tau->map, NULL);
+}
+
+TEST_F_TEARDOWN(sharded) { tau->map = hm_int_sharded_delete(tau->map, NULL); }
+
+TEST(sharded, test_invalid_arguments)
+{
+	CHECK_PTR_EQ(hm_int_sharded_new(0, 2), NULL);
+	CHECK_PTR_EQ(hm_int_sharded_new(8, HASHMAP_MAX_SHARD_BITS + 1), NULL);
+	CHECK(hm_int_sharded_insert(NULL, (u8mem){0}, 0) == false);
+	CHECK(hm_int_sharded_search(NULL, NULL, (u8mem){0}) == false);
+	CHECK(hm_int_sharded_used(NULL) == -1);
+	CHECK(hm_int_sharded_capacity(NULL) == -1);
+}
+
+TEST_F(sharded, test_shards)
+{
+	ShardedHashMap_int *const restrict map = hm_int_sharded_new(8, 0);
+
+	REQUIRE_PTR_NE(map, NULL);
+	CHECK(map->shard_count == 1);
+	CHECK(hm_int_sharded_capacity(map) == 8);
+	hm_int_sharded_delete(map, NULL);
+
+	unsigned char mem[] = "key";
+	const u8mem key = {.len = sizeof(mem) - 1, .buf = mem};
+	int data = -1;
+
+	CHECK(tau->map->shard_count == 4);
+	CHECK(hm_int_sharded_capacity(tau->map) == 8);
+	CHECK(hm_int_sharded_insert(tau->map, (u8mem){0}, 1) == false);
+	REQUIRE(hm_int_sharded_insert(tau->map, key, 1) == true);
+	REQUIRE(hm_int_sharded_insert(tau->map, key, 2) == true);
+	CHECK(hm_int_sharded_used(tau->map) == 1);
+	CHECK(hm_int_sharded_search(tau->map, &data, key) == true);
+	CHECK(data == 2);
+	CHECK(hm_int_sharded_remove(tau->map, &data, key) == true);
+	CHECK(hm_int_sharded_search(tau->map, NULL, key) == false);
+	CHECK(hm_int_sharded_used(tau->map) == 0);
+}
+
+TEST_F(sharded, test_shards_grow_alone)
+{
+	const len_ty capacity = tau->map->shards[0].map->capacity;
+	int i = 0;
+
+	for (; hm_int_sharded_capacity(tau->map) == 4 * capacity; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+
+		REQUIRE(hm_int_sharded_insert(tau->map, key, i) == true);
+	}
+
+	len_ty grown = 0;
+
+	for (len_ty s = 0; s < tau->map->shard_count; s++)
+		grown += tau->map->shards[s].map->capacity != capacity;
+
+	CHECK(grown == 1);
+	CHECK(hm_int_sharded_used(tau->map) == i);
+}
+
+TEST_F(sharded, test_shards_shrink_alone)
+{
+	const int keys = 1000;
+
+	for (int i = 0; i < keys; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+
+		REQUIRE(hm_int_sharded_insert(tau->map, key, i) == true);
+	}
+
+	const len_ty capacity = hm_int_sharded_capacity(tau->map);
+
+	for (int i = 0; i < keys; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+
+		REQUIRE(hm_int_sharded_remove(tau->map, NULL, key) == true);
+	}
+
+	CHECK(hm_int_sharded_used(tau->map) == 0);
+	CHECK(
+		hm_int_sharded_capacity(tau->map) <=
+		HASHMAP_MIN_TRIM_CAPACITY * tau->map->shard_count
+	);
+	CHECK(hm_int_sharded_capacity(tau->map) < capacity);
+}
+
+static int sharded_worker(void *arg)
+{
+	struct worker *const w = arg;
+
+	for (int i = w->first; i < w->first + THREAD_KEYS; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+
+		if (!hm_int_sharded_insert(w->map, key, i))
+			w->errors++;
+	}
+
+	for (int i = w->first; i < w->first + THREAD_KEYS; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+		int data = -1;
+
+		if (!hm_int_sharded_search(w->map, &data, key) || data != i)
+			w->errors++;
+
+		if (i % 2 && !hm_int_sharded_remove(w->map, NULL, key))
+			w->errors++;
+	}
+
+	return (0);
+}
+
+TEST_F(sharded, test_parallel_operations)
+{
+	thrd_t threads[THREAD_COUNT];
+	struct worker workers[THREAD_COUNT];
+
+	for (int t = 0; t < THREAD_COUNT; t++)
+	{
+		workers[t] = (struct worker){tau->map, t * THREAD_KEYS, 0};
+		REQUIRE(
+			thrd_create(&threads[t], sharded_worker, &workers[t]) ==
+			thrd_success
+		);
+	}
+
+	for (int t = 0; t < THREAD_COUNT; t++)
+	{
+		REQUIRE(thrd_join(threads[t], NULL) == thrd_success);
+		CHECK(workers[t].errors == 0);
+	}
+
+	CHECK(hm_int_sharded_used(tau->map) == THREAD_COUNT * THREAD_KEYS / 2);
+	for (int i = 0; i < THREAD_COUNT * THREAD_KEYS; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+
+		CHECK(hm_int_sharded_search(tau->map, NULL, key) == !(i % 2));
+	}
+}
+
+/*###################################################################*/
+/*############################### rcu ###############################*/
+/*###################################################################*/
+
+struct rcu
+{
+	RcuHashMap_id *restrict map;
+};
+
+TEST_F_SETUP(rcu)
+{
+	tau->map = hm_id_rcu_new(8);
+	REQUIRE_PTR_NE(tau->map, NULL);
+}
+
+TEST_F_TEARDOWN(rcu) { tau->map = hm_id_rcu_delete(tau->map, NULL); }
+
+TEST_F(rcu, test_insert_search_remove)
+{
+	int data = -1;
+
+	CHECK(hm_id_rcu_search(NULL, &data, 1) == false);
+	CHECK(hm_id_rcu_search(tau->map, &data, 1) == false);
+	REQUIRE(hm_id_rcu_insert(tau->map, 1, 10) == true);
+	REQUIRE(hm_id_rcu_insert(tau->map, 1, 11) == true);
+	CHECK(hm_id_rcu_search(tau->map, &data, 1) == true);
+	CHECK(data == 11);
+	CHECK(hm_id_rcu_grow(tau->map, 64) == true);
+	CHECK(atomic_load(&tau->map->map)->capacity >= 64);
+	CHECK(hm_id_rcu_search(tau->map, NULL, 1) == true);
+	CHECK(hm_id_rcu_remove(tau->map, &data, 1) == true);
+	CHECK(data == 11);
+	CHECK(hm_id_rcu_remove(tau->map, &data, 1) == false);
+	CHECK(hm_id_rcu_search(tau->map, NULL, 1) == false);
+
+	/* Removals trim the map. */
+	CHECK(hm_id_rcu_grow(tau->map, 1024) == true);
+	REQUIRE(hm_id_rcu_insert(tau->map, 2, 20) == true);
+	REQUIRE(hm_id_rcu_insert(tau->map, 3, 30) == true);
+	CHECK(hm_id_rcu_remove(tau->map, NULL, 2) == true);
+	CHECK(atomic_load(&tau->map->map)->capacity <= HASHMAP_MIN_TRIM_CAPACITY);
+	CHECK(hm_id_rcu_search(tau->map, &data, 3) == true);
+	CHECK(data == 30);
+}
+
+/*! @brief arguments of a thread searching an RCU HashMap. */
+struct rcu_reader
+{
+	RcuHashMap_id *map;
+	atomic_bool *stop;
+	int errors;
+};
+
+static int rcu_reader(void *arg)
+{
+	struct rcu_reader *const r = arg;
+
+	while (!atomic_load(r->stop))
+	{
+		for (int i = 0; i < 100; i++)
+		{
+			int data = -1;
+
+			if (!hm_id_rcu_search(r->map, &data, (uint64_t)i) || data != i)
+				r->errors++;
+		}
+
+		thrd_yield();
+	}
+
+	return (0);
+}
+
+TEST_F(rcu, test_writes_during_searches)
+{
+	thrd_t threads[THREAD_COUNT];
+	struct rcu_reader readers[THREAD_COUNT];
+	atomic_bool stop = false;
+
+	for (int i = 0; i < 100; i++)
+		REQUIRE(hm_id_rcu_insert(tau->map, (uint64_t)i, i) == true);
+
+	for (int t = 0; t < THREAD_COUNT; t++)
+	{
+		readers[t] = (struct rcu_reader){tau->map, &stop, 0};
+		REQUIRE(
+			thrd_create(&threads[t], rcu_reader, &readers[t]) == thrd_success
+		);
+	}
+
+	/* Keys 0 to 99 stay while the others come and go. */
+	for (int i = 100; i < 120; i++)
+		CHECK(hm_id_rcu_insert(tau->map, (uint64_t)i, i) == true);
+
+	CHECK(hm_id_rcu_grow(tau->map, 1024) == true);
+	for (int i = 100; i < 120; i++)
+		CHECK(hm_id_rcu_remove(tau->map, NULL, (uint64_t)i) == true);
+
+	atomic_store(&stop, true);
+	for (int t = 0; t < THREAD_COUNT; t++)
+	{
+		REQUIRE(thrd_join(threads[t], NULL) == thrd_success);
+		CHECK(readers[t].errors == 0);
+	}
+}
+
+/*###################################################################*/
+/*############################# handles #############################*/
+/*###################################################################*/
+
+struct handles
+{
+	HashMapHandle_int *restrict map;
+};
+
+TEST_F_SETUP(handles)
+{
+	tau->map = hm_int_handle_new(8);
+	REQUIRE_PTR_NE(tau->map, NULL);
+}
+
+TEST_F_TEARDOWN(handles) { tau->map = hm_int_handle_delete(tau->map, NULL); }
+
+TEST(handles, test_invalid_arguments)
+{
+	CHECK_PTR_EQ(hm_int_handle_new(0), NULL);
+	CHECK_PTR_EQ(hm_int_handle_insert(NULL, (u8mem){0}, 0), NULL);
+	CHECK_PTR_EQ(hm_int_handle_search(NULL, (u8mem){0}), NULL);
+	CHECK(hm_int_handle_remove(NULL, NULL, (u8mem){0}) == false);
+	CHECK(hm_int_handle_grow(NULL, 8) == false);
+	CHECK(hm_int_handle_shrink(NULL, 8) == false);
+	CHECK_PTR_EQ(hm_int_handle_map(NULL), NULL);
+}
+
+TEST_F(handles, test_resizes_keep_the_handle)
+{
+	const int keys = 1000;
+
+	for (int i = 0; i < keys; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+
+		REQUIRE_PTR_NE(hm_int_handle_insert(tau->map, key, i), NULL);
+	}
+
+	CHECK(hm_int_handle_map(tau->map)->capacity > 8);
+	REQUIRE(hm_int_handle_grow(tau->map, 4096) == true);
+	CHECK(hm_int_handle_map(tau->map)->capacity >= 4096);
+	for (int i = 0; i < keys; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+		const int *const data = hm_int_handle_search(tau->map, key);
+
+		REQUIRE_PTR_NE(data, NULL);
+		CHECK(*data == i);
+	}
+
+	REQUIRE(hm_int_handle_shrink(tau->map, 1) == true);
+	CHECK(hm_int_handle_map(tau->map)->capacity < 4096);
+	for (int i = 1; i < keys; i++)
+	{
+		const u8mem key = {.len = sizeof(i), .buf = (unsigned char *)&i};
+		int data = -1;
+
+		REQUIRE(hm_int_handle_remove(tau->map, &data, key) == true);
+		CHECK(data == i);
+	}
+
+	const int zero = 0;
+	const u8mem key = {.len = sizeof(zero), .buf = (unsigned char *)&zero};
+
+	CHECK_PTR_NE(hm_int_handle_search(tau->map, key), NULL);
+	/* The removals trimmed the HashMap. */
+	CHECK(hm_int_handle_map(tau->map)->capacity <= HASHMAP_MIN_TRIM_CAPACITY);
+}
@@ -0,0 +1,156 @@
+#ifndef WYHASH_HASH
+#define WYHASH_HASH
+
+// wyhash was written by Wang Yi, and is released into the public domain
+// under The Unlicense. This is the final version 4.2 of the algorithm.
+// https://github.com/wangyi-fudan/wyhash
+
+#include "compiler_attributes_macros.h"
+
+#include <stddef.h>  // size_t
+#include <stdint.h>  // uint32_t, uint64_t
+#include <string.h>  // memcpy
+
+/*! @brief default secret of wyhash. */
+static const uint64_t wyhash_secret[4] = {
+	0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL,
+	0x4d5a2da51de1aa47ULL,
+};
+
+/*!
+ * @brief 128 bit multiply of two 64 bit numbers.
+ *
+ * @param a address of the first number, set to the low 64 bits.
+ * @param b address of the second number, set to the high 64 bits.
+ */
+static inline void
+wy_mum(uint64_t *const restrict a, uint64_t *const restrict b)
+{
+#ifdef __SIZEOF_INT128__
+	__extension__ typedef unsigned __int128 wy_u128;
+	const wy_u128 r = (wy_u128)*a * *b;
+
+	*a = (uint64_t)r;
+	*b = (uint64_t)(r >> 64);
+#else
+	const uint64_t ha = *a >> 32, hb = *b >> 32;
+	const uint64_t la = (uint32_t)*a, lb = (uint32_t)*b;
+	const uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+	const uint64_t t = rl + (rm0 << 32);
+	uint64_t c = t < rl;
+	const uint64_t lo = t + (rm1 << 32);
+
+	c += lo < t;
+	*a = lo;
+	*b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif /* __SIZEOF_INT128__ */
+}
+
+/*! @brief multiply and xor mix. */
+static inline uint64_t wy_mix(uint64_t a, uint64_t b)
+{
+	wy_mum(&a, &b);
+	return (a ^ b);
+}
+
+/*! @brief Read 8 bytes from pointer. */
+static inline uint64_t wy_r8(const unsigned char *const restrict p)
+{
+	uint64_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return (v);
+}
+
+/*! @brief Read 4 bytes from pointer. */
+static inline uint64_t wy_r4(const unsigned char *const restrict p)
+{
+	uint32_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return (v);
+}
+
+/*! @brief Read 1 to 3 bytes from pointer. */
+static inline uint64_t wy_r3(const unsigned char *const restrict p, size_t k)
+{
+	return (((uint64_t)p[0] << 16) | ((uint64_t)p[k >> 1] << 8) | p[k - 1]);
+}
+
+static void wyhash(
+	const unsigned char *const restrict key, const size_t len,
+	void *const restrict out
+) _nonnull;
+
+/*!
+ * @brief 64 bit wyhash of a buffer, 48 bytes per round.
+ *
+ * @param key start of buffer to hash.
+ * @param len length of buffer in octets.
+ * @param out pointer to a `uint64_t` initialised to the seed.
+ */
+static void wyhash(
+	const unsigned char *const restrict key, const size_t len,
+	void *const restrict out
+)
+{
+	uint64_t *const restrict dest = out;
+	const uint64_t *const s = wyhash_secret;
+	const unsigned char *p = key;
+	uint64_t seed = *dest, a, b;
+
+	seed ^= wy_mix(seed ^ s[0], s[1]);
+	if (len <= 16)
+	{
+		if (len >= 4)
+		{
+			a = (wy_r4(p) << 32) | wy_r4(p + ((len >> 3) << 2));
+			b = (wy_r4(p + len - 4) << 32) |
+				wy_r4(p + len - 4 - ((len >> 3) << 2));
+		}
+		else if (len > 0)
+		{
+			a = wy_r3(p, len);
+			b = 0;
+		}
+		else
+			a = b = 0;
+	}
+	else
+	{
+		size_t i = len;
+
+		if (i >= 48)
+		{
+			uint64_t see1 = seed, see2 = seed;
+
+			do
+			{
+				seed = wy_mix(wy_r8(p) ^ s[1], wy_r8(p + 8) ^ seed);
+				see1 = wy_mix(wy_r8(p + 16) ^ s[2], wy_r8(p + 24) ^ see1);
+				see2 = wy_mix(wy_r8(p + 32) ^ s[3], wy_r8(p + 40) ^ see2);
+				p += 48;
+				i -= 48;
+			} while (i >= 48);
+
+			seed ^= see1 ^ see2;
+		}
+
+		while (i > 16)
+		{
+			seed = wy_mix(wy_r8(p) ^ s[1], wy_r8(p + 8) ^ seed);
+			i -= 16;
+			p += 16;
+		}
+
+		a = wy_r8(p + i - 16);
+		b = wy_r8(p + i - 8);
+	}
+
+	a ^= s[1];
+	b ^= seed;
+	wy_mum(&a, &b);
+	*dest = wy_mix(a ^ s[0] ^ len, b ^ s[1]);
+}
+
+#endif /* WYHASH_HASH */